@@ -0,0 +1,98 @@
+#include <networkprotocoldsl/value.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+/**
+ * Measures how many Values holding octets can be created and copied
+ * per second.
+ *
+ * LegacyValue reproduces the previous representation, where Octets
+ * kept every payload behind a std::shared_ptr<const std::string>, so
+ * both sides pay the same variant overhead. A short token is kept
+ * inline by the current representation, a long payload is still
+ * shared.
+ */
+
+using namespace networkprotocoldsl;
+
+struct LegacyOctets {
+  std::shared_ptr<const std::string> data;
+};
+
+using LegacyValue =
+    std::variant<bool, int32_t, value::Dictionary, value::Callable,
+                 value::RuntimeError, value::ControlFlowInstruction,
+                 value::DynamicList, LegacyOctets>;
+
+static constexpr size_t batch = 64;
+static constexpr size_t rounds = 200000;
+
+template <typename T> static double copies_per_second(const T &original) {
+  std::vector<T> copies(batch);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < batch; i++) {
+      copies[i] = original;
+    }
+    // release the copies so every round pays for both sides.
+    for (size_t i = 0; i < batch; i++) {
+      copies[i] = T();
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return (batch * rounds) / elapsed.count();
+}
+
+template <typename T, typename F>
+static double creations_per_second(const std::string &token, F make) {
+  std::vector<T> values(batch);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < batch; i++) {
+      values[i] = make(token);
+    }
+    for (size_t i = 0; i < batch; i++) {
+      values[i] = T();
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return (batch * rounds) / elapsed.count();
+}
+
+static void report(const std::string &name, double rate) {
+  std::cout << name << ": " << static_cast<uint64_t>(rate) << " per sec"
+            << std::endl;
+}
+
+static LegacyValue make_legacy(const std::string &s) {
+  return LegacyOctets{std::make_shared<const std::string>(s)};
+}
+
+static Value make_current(const std::string &s) { return value::Octets(s); }
+
+int main() {
+  std::string short_token = "example.com";
+  std::string long_payload(256, 'x');
+
+  report("create short, before",
+         creations_per_second<LegacyValue>(short_token, make_legacy));
+  report("create short, after",
+         creations_per_second<Value>(short_token, make_current));
+  report("copy short, before", copies_per_second(make_legacy(short_token)));
+  report("copy short, after", copies_per_second(make_current(short_token)));
+  report("create long, before",
+         creations_per_second<LegacyValue>(long_payload, make_legacy));
+  report("create long, after",
+         creations_per_second<Value>(long_payload, make_current));
+  report("copy long, before", copies_per_second(make_legacy(long_payload)));
+  report("copy long, after", copies_per_second(make_current(long_payload)));
+  report("copy int32", copies_per_second(Value(int32_t(42))));
+  return 0;
+}
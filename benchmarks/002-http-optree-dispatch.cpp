@@ -0,0 +1,77 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Measures how fast the interpreter steps through the HTTP optrees
+ * from the test library, reading a request and writing it back, with
+ * the input and output kept in memory so only the dispatch of the
+ * operations is measured.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr size_t messages = 20000;
+
+int main() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  auto main_optree = std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}}));
+  InterpretedProgram p(main_optree);
+
+  std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                      "Accept: application/json\r\n"
+                      "Host: Test Value\r\n"
+                      "\r\n";
+
+  uint64_t steps = 0;
+  uint64_t output_bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t m = 0; m < messages; m++) {
+    Interpreter i = p.get_instance();
+    std::string_view remaining(input);
+    while (true) {
+      ContinuationState s = i.step();
+      steps++;
+      if (s == ContinuationState::Blocked) {
+        auto reason = std::get<ReasonForBlockedOperation>(i.get_result());
+        if (reason == ReasonForBlockedOperation::WaitingForWrite) {
+          auto buffer = i.get_write_buffer();
+          output_bytes += buffer.size();
+          i.handle_write(buffer.size());
+        } else if (reason == ReasonForBlockedOperation::WaitingForRead) {
+          size_t movement = i.handle_read(remaining);
+          remaining.remove_prefix(std::min(movement, remaining.size()));
+        }
+      } else if (s == ContinuationState::Exited) {
+        break;
+      }
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (output_bytes != messages * input.size()) {
+    std::cerr << "unexpected output size: " << output_bytes << std::endl;
+    return 1;
+  }
+  std::cout << "messages: " << static_cast<uint64_t>(messages / elapsed.count())
+            << " per sec" << std::endl;
+  std::cout << "steps: " << static_cast<uint64_t>(steps / elapsed.count())
+            << " per sec" << std::endl;
+  std::cout << "steps per message: " << steps / messages << std::endl;
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Measures how the throughput of the InterpreterRunner scales with the
+ * number of interpreter workers. Every connection reads one HTTP
+ * request from its input queue and writes it back, so the runner and
+ * the interpreters are all that is measured.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int connections = 4000;
+
+static double run(const InterpretedProgram &p, const std::string &input,
+                  std::size_t workers) {
+  InterpreterCollectionManager mgr;
+  std::vector<std::future<Value>> results;
+  for (int c = 0; c < connections; c++) {
+    results.push_back(mgr.insert_interpreter(c, p));
+    auto context = mgr.get_collection()->interpreters.at(c);
+    context->input_buffer.push_back(input);
+  }
+
+  InterpreterRunner runner;
+  runner.exit_when_done = true;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (std::size_t w = 0; w < workers; w++) {
+    threads.emplace_back([&runner, &mgr, w, workers] {
+      runner.interpreter_loop(mgr, w, workers);
+    });
+  }
+  for (auto &result : results) {
+    result.wait();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return connections / elapsed.count();
+}
+
+int main() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+
+  std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                      "Accept: application/json\r\n"
+                      "Host: Test Value\r\n"
+                      "\r\n";
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  for (std::size_t workers : {1, 2, 4, 8}) {
+    std::cout << "workers: " << workers << " messages: "
+              << static_cast<uint64_t>(run(p, input, workers)) << " per sec"
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Measures how long it takes for a request to make it through one
+ * connection while a growing number of other connections sit idle,
+ * waiting for input that never comes. Only the connection that
+ * received something should be looked at, so the latency should not
+ * depend on how many idle connections there are.
+ *
+ * The largest number of idle connections can be given as the first
+ * argument.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int probes = 200;
+
+static const std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                                 "Accept: application/json\r\n"
+                                 "Host: Test Value\r\n"
+                                 "\r\n";
+
+static void send_request(InterpreterCollectionManager &mgr, int fd) {
+  auto collection = mgr.get_collection();
+  auto context = collection->interpreters.at(fd);
+  context->input_buffer.push_back(input);
+  collection->signals->schedule(context);
+}
+
+static void run(const InterpretedProgram &p, int idle) {
+  InterpreterCollectionManager mgr;
+  for (int c = 0; c < idle; c++) {
+    mgr.insert_interpreter(c, p);
+  }
+  std::vector<std::future<Value>> warm_up;
+  std::vector<std::future<Value>> measured;
+  for (int c = 0; c < probes; c++) {
+    warm_up.push_back(mgr.insert_interpreter(idle + c, p));
+    measured.push_back(mgr.insert_interpreter(idle + probes + c, p));
+  }
+
+  InterpreterRunner runner;
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+
+  // by the time these are done, the idle connections are all blocked
+  // waiting for input.
+  for (int c = 0; c < probes; c++) {
+    send_request(mgr, idle + c);
+  }
+  for (auto &f : warm_up) {
+    f.wait();
+  }
+
+  std::vector<double> latencies;
+  for (int c = 0; c < probes; c++) {
+    auto start = std::chrono::steady_clock::now();
+    send_request(mgr, idle + probes + c);
+    measured[c].wait();
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    latencies.push_back(elapsed.count());
+  }
+
+  runner.exit_when_done = true;
+  for (int c = 0; c < idle; c++) {
+    auto collection = mgr.get_collection();
+    auto context = collection->interpreters.at(c);
+    context->eof.store(true);
+    collection->signals->schedule(context);
+  }
+  worker.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "idle connections: " << idle << " wakeup latency: median "
+            << static_cast<uint64_t>(latencies[probes / 2]) << " us, p99 "
+            << static_cast<uint64_t>(latencies[probes * 99 / 100]) << " us"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  int max_idle = argc > 1 ? std::atoi(argv[1]) : 100000;
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+
+  for (int idle = 10; idle <= max_idle; idle *= 10) {
+    run(p, idle);
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Compares how many steps the InterpreterRunner gives an interpreter
+ * each time it picks it up. All connections get a request at the same
+ * time; the throughput is how fast they are all answered, the latency
+ * is how long it takes for each of them to be answered, which grows
+ * for the late ones when a large quantum lets the early ones run
+ * undisturbed.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int connections = 4000;
+
+static void run(const InterpretedProgram &p, const std::string &input,
+                std::size_t quantum) {
+  InterpreterCollectionManager mgr;
+  std::vector<std::future<Value>> results;
+  for (int c = 0; c < connections; c++) {
+    results.push_back(mgr.insert_interpreter(c, p));
+    auto context = mgr.get_collection()->interpreters.at(c);
+    context->input_buffer.push_back(input);
+  }
+
+  InterpreterRunner runner;
+  runner.exit_when_done = true;
+  runner.steps_per_quantum = quantum;
+
+  // polls for the connections that were answered, so the latency of
+  // each of them is known within a few microseconds.
+  std::vector<double> latencies;
+  std::atomic<bool> started = false;
+  auto start = std::chrono::steady_clock::now();
+  std::thread watcher([&] {
+    while (!started.load()) {
+    }
+    auto collection = mgr.get_collection();
+    std::vector<bool> answered(connections, false);
+    while (latencies.size() < connections) {
+      for (int c = 0; c < connections; c++) {
+        if (!answered[c] && collection->interpreters.at(c)->exited.load()) {
+          answered[c] = true;
+          std::chrono::duration<double, std::micro> elapsed =
+              std::chrono::steady_clock::now() - start;
+          latencies.push_back(elapsed.count());
+        }
+      }
+      std::this_thread::yield();
+    }
+  });
+
+  start = std::chrono::steady_clock::now();
+  started.store(true);
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  for (auto &result : results) {
+    result.wait();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  worker.join();
+  watcher.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "quantum: " << quantum << " messages: "
+            << static_cast<uint64_t>(connections / elapsed.count())
+            << " per sec, latency: median "
+            << static_cast<uint64_t>(latencies[connections / 2]) << " us, p99 "
+            << static_cast<uint64_t>(latencies[connections * 99 / 100])
+            << " us" << std::endl;
+}
+
+int main() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+
+  std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                      "Accept: application/json\r\n"
+                      "Host: Test Value\r\n"
+                      "\r\n";
+
+  for (std::size_t quantum : {1, 4, 16, 64, 256, 4096}) {
+    run(p, input, quantum);
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Measures how fast connections can be added to and removed from the
+ * InterpreterCollectionManager while a number of other connections
+ * stay open, both from a single thread and from several threads at
+ * once as in a connection storm. Adding a connection should not get
+ * slower as more of them are open.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int cycles = 50000;
+
+static void run(const InterpretedProgram &p, int open, int threads) {
+  InterpreterCollectionManager mgr;
+  for (int c = 0; c < open; c++) {
+    mgr.insert_interpreter(c, p);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> churners;
+  for (int t = 0; t < threads; t++) {
+    churners.emplace_back([&mgr, &p, open, threads, t] {
+      for (int c = t; c < cycles; c += threads) {
+        int fd = open + c;
+        mgr.insert_interpreter(fd, p);
+        mgr.remove_interpreter(fd);
+      }
+    });
+  }
+  for (auto &churner : churners) {
+    churner.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "open connections: " << open << " threads: " << threads
+            << " accepts: " << static_cast<uint64_t>(cycles / elapsed.count())
+            << " per sec" << std::endl;
+}
+
+int main() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+
+  for (int open : {0, 1000, 10000, 100000}) {
+    for (int threads : {1, 4}) {
+      run(p, open, threads);
+    }
+  }
+  return 0;
+}
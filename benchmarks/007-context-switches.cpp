@@ -0,0 +1,103 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+/**
+ * Counts the context switches it takes to answer a message. Each
+ * message comes in on a new connection and the answer is taken by an
+ * output thread waiting on wake_up_for_output, like the one of the
+ * libuv server, while the callback loop runs next to them with nothing
+ * to do. Ideally only the threads that have something to do are woken
+ * up: the interpreter worker, the output thread and whoever waits for
+ * the answer.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int messages = 2000;
+
+static const std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                                 "Accept: application/json\r\n"
+                                 "Host: Test Value\r\n"
+                                 "\r\n";
+
+static std::uint64_t context_switches() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+int main() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+
+  InterpreterCollectionManager mgr;
+  InterpreterRunner runner;
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+
+  std::vector<std::promise<void>> answered(messages);
+  std::atomic<bool> done = false;
+  std::thread output([&mgr, &answered, &done] {
+    std::vector<std::size_t> received(messages, 0);
+    while (!done.load()) {
+      auto collection = mgr.get_collection();
+      for (const auto &[fd, context] : collection->interpreters) {
+        while (auto buffer = context->output_buffer.pop()) {
+          received[fd] += buffer->data.view().size();
+          if (received[fd] == input.size()) {
+            answered[fd].set_value();
+          }
+        }
+      }
+      collection->signals->wake_up_for_output.wait();
+    }
+  });
+
+  std::uint64_t before = context_switches();
+  for (int fd = 0; fd < messages; fd++) {
+    mgr.insert_interpreter(fd, p);
+    auto collection = mgr.get_collection();
+    auto context = collection->interpreters.at(fd);
+    context->input_buffer.push_back(input);
+    collection->signals->schedule(context);
+    answered[fd].get_future().wait();
+    mgr.remove_interpreter(fd);
+  }
+  std::uint64_t after = context_switches();
+
+  runner.exit_when_done = true;
+  done.store(true);
+  auto signals = mgr.get_collection()->signals;
+  signals->wake_up_for_output.notify();
+  signals->wake_up_for_callback.notify();
+  signals->wake_up_interpreter.notify();
+  output.join();
+  worker.join();
+  callbacks.join();
+
+  std::cout << "context switches per message: "
+            << static_cast<double>(after - before) / messages << std::endl;
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/unarycallback.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * Measures how the callback throughput scales with the number of
+ * callback threads, when every callback takes a millisecond, like one
+ * that writes to a file or asks another service. Every connection
+ * runs a single callback.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int connections = 400;
+
+static double run(const InterpretedProgram &p, std::size_t threads) {
+  InterpreterCollectionManager mgr;
+  std::vector<std::future<Value>> results;
+  for (int c = 0; c < connections; c++) {
+    results.push_back(mgr.insert_interpreter(c, p));
+  }
+  InterpreterRunner runner;
+  runner.callbacks.emplace("slow", [](const std::vector<Value> &args) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return args[0];
+  });
+  runner.exit_when_done = true;
+  runner.callback_threads = threads;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+  for (auto &result : results) {
+    result.wait();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  worker.join();
+  callbacks.join();
+  return connections / elapsed.count();
+}
+
+int main() {
+  operation::UnaryCallback callback("slow");
+  operation::Int32Literal argument(1);
+  InterpretedProgram p(
+      std::make_shared<OpTree>(OpTree({callback, {{argument, {}}}})));
+
+  for (std::size_t threads : {1, 2, 4, 8, 16, 32}) {
+    std::cout << "callback threads: " << threads << " callbacks: "
+              << static_cast<uint64_t>(run(p, threads)) << " per sec"
+              << std::endl;
+  }
+  return 0;
+}
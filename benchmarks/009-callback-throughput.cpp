@@ -0,0 +1,74 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/opsequence.hpp>
+#include <networkprotocoldsl/operation/unarycallback.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Measures how many callbacks per second go from the interpreters to
+ * the callback loop and back, when the callbacks themselves do
+ * nothing. Every connection runs a sequence of callbacks, and the
+ * runner knows about a few dozen other keys, like an application
+ * handling every state of a protocol.
+ */
+
+using namespace networkprotocoldsl;
+
+static constexpr int connections = 100;
+static constexpr int callbacks_per_connection = 200;
+
+static double run(const InterpretedProgram &p) {
+  InterpreterCollectionManager mgr;
+  std::vector<std::future<Value>> results;
+  for (int c = 0; c < connections; c++) {
+    results.push_back(mgr.insert_interpreter(c, p));
+  }
+  InterpreterRunner runner;
+  for (int k = 0; k < 64; k++) {
+    runner.callbacks.emplace("State" + std::to_string(k),
+                             [](const std::vector<Value> &args) {
+                               return args[0];
+                             });
+  }
+  runner.callbacks.emplace(
+      "echo", [](const std::vector<Value> &args) { return args[0]; });
+  runner.exit_when_done = true;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+  for (auto &result : results) {
+    result.wait();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  worker.join();
+  callbacks.join();
+  return connections * callbacks_per_connection / elapsed.count();
+}
+
+int main() {
+  operation::OpSequence ops;
+  operation::UnaryCallback callback("echo");
+  std::vector<OpTreeNode> calls;
+  for (int i = 0; i < callbacks_per_connection; i++) {
+    calls.push_back({callback, {{operation::Int32Literal(i), {}}}});
+  }
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({ops, calls})));
+
+  for (int round = 0; round < 3; round++) {
+    std::cout << "callbacks: " << static_cast<uint64_t>(run(p)) << " per sec"
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include <networkprotocoldsl/support/patternscanner.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Measures how fast the header lines of HTTP requests and the body of
+ * SMTP messages are scanned for their terminators, with
+ * std::string_view::find as the interpreter used to, and with the
+ * pattern scanner on each implementation the processor supports.
+ */
+
+using networkprotocoldsl::support::PatternScanner;
+
+static std::string http_traffic() {
+  std::string out;
+  while (out.size() < 8 * 1024 * 1024) {
+    out += "GET /index.html HTTP/1.1\r\n"
+           "Host: www.example.com\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) "
+           "Gecko/20100101 Firefox/120.0\r\n"
+           "Accept: text/html,application/xhtml+xml,application/xml;"
+           "q=0.9,*/*;q=0.8\r\n"
+           "Accept-Language: en-US,en;q=0.5\r\n"
+           "Content-Type: text/plain;\r\n charset=utf-8\r\n"
+           "Connection: keep-alive\r\n"
+           "\r\n";
+  }
+  return out;
+}
+
+static std::string smtp_body() {
+  std::string out;
+  while (out.size() < 8 * 1024 * 1024) {
+    out += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+           "eiusmod\r\ntempor incididunt ut labore et dolore magna aliqua. "
+           "Ut enim ad minim\r\n..veniam, quis nostrud exercitation ullamco "
+           "laboris nisi ut aliquip ex\r\n";
+  }
+  return out + ".\r\n";
+}
+
+template <typename F> static void report(const char *name, std::size_t bytes,
+                                         F f) {
+  std::uint64_t result = 0;
+  auto start = std::chrono::steady_clock::now();
+  constexpr int rounds = 10;
+  for (int round = 0; round < rounds; round++) {
+    result += f();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": "
+            << static_cast<std::uint64_t>(rounds * bytes / elapsed.count() /
+                                          (1024 * 1024))
+            << " MB/s (" << result / rounds << ")" << std::endl;
+}
+
+static const char *name(PatternScanner::Implementation i) {
+  switch (i) {
+  case PatternScanner::Implementation::Scalar:
+    return "scalar";
+  case PatternScanner::Implementation::SSE2:
+    return "sse2";
+  case PatternScanner::Implementation::AVX2:
+    return "avx2";
+  }
+  return "?";
+}
+
+int main() {
+  const std::string http = http_traffic();
+  const std::string smtp = smtp_body();
+
+  // header lines, where "\r\n " continues a header on the next line.
+  report("http lines, two finds", http.size(), [&] {
+    std::string_view in = http;
+    std::uint64_t lines = 0;
+    std::size_t pos = 0;
+    while (true) {
+      auto term = in.find("\r\n", pos);
+      auto esc = in.find("\r\n ", pos);
+      if (term == in.npos) {
+        break;
+      }
+      pos = (esc != in.npos && esc <= term) ? esc + 3 : term + 2;
+      lines++;
+    }
+    return lines;
+  });
+  // the end of the data, looked for at once in the whole body.
+  report("smtp data, find", smtp.size(), [&] {
+    return std::string_view(smtp).find("\r\n.\r\n");
+  });
+
+  for (auto impl :
+       {PatternScanner::Implementation::Scalar,
+        PatternScanner::Implementation::SSE2,
+        PatternScanner::Implementation::AVX2}) {
+    if (!PatternScanner::supported(impl)) {
+      continue;
+    }
+    PatternScanner lines({"\r\n ", "\r\n"}, impl);
+    PatternScanner data({"\r\n..", "\r\n.\r\n"}, impl);
+    std::string http_name = std::string("http lines, ") + name(impl);
+    report(http_name.c_str(), http.size(), [&] {
+      std::string_view in = http;
+      std::uint64_t count = 0;
+      std::size_t pos = 0;
+      while (true) {
+        auto m = lines.find(in, pos);
+        if (m.position == in.npos) {
+          break;
+        }
+        pos = m.position + lines.get_patterns()[m.pattern].size();
+        count++;
+      }
+      return count;
+    });
+    // dot-stuffed lines are escapes, scanned for in the same pass.
+    std::string smtp_name = std::string("smtp data, ") + name(impl);
+    report(smtp_name.c_str(), smtp.size(), [&] {
+      std::string_view in = smtp;
+      std::size_t pos = 0;
+      while (true) {
+        auto m = data.find(in, pos);
+        if (m.position == in.npos || m.pattern == 1) {
+          return m.position;
+        }
+        pos = m.position + 4;
+      }
+    });
+  }
+  return 0;
+}
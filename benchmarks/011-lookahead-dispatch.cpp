@@ -0,0 +1,52 @@
+#include <networkprotocoldsl/operation/transitionlookahead.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Measures how long a lookahead takes to pick a transition among more
+ * and more static strings, such as the commands of a protocol, which
+ * share a prefix. Each dispatch is a fresh frame given the line at
+ * once, and the line is the last of the commands, so that the work
+ * done for each of the ones before it shows.
+ */
+
+using namespace networkprotocoldsl;
+using networkprotocoldsl::operation::TransitionLookahead;
+
+static void report(std::size_t candidates) {
+  std::vector<std::pair<TransitionLookahead::TransitionCondition, int32_t>>
+      conditions;
+  for (std::size_t i = 0; i < candidates; i++) {
+    conditions.emplace_back("X-COMMAND-" + std::to_string(i) + " ",
+                            static_cast<int32_t>(i));
+  }
+  conditions.emplace_back(TransitionLookahead::EOFCondition{}, -1);
+  TransitionLookahead lookahead{conditions};
+  const std::string line =
+      "X-COMMAND-" + std::to_string(candidates - 1) + " argument\r\n";
+
+  constexpr int rounds = 200000;
+  std::int64_t result = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    InputOutputOperationContext ctx;
+    lookahead.handle_read(ctx, line);
+    result += std::get<int32_t>(std::get<Value>(lookahead(ctx, {})));
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << candidates << " candidates: "
+            << static_cast<std::uint64_t>(elapsed.count() / rounds)
+            << " ns per dispatch (" << result / rounds << ")" << std::endl;
+}
+
+int main() {
+  for (std::size_t candidates : {2, 8, 32, 128, 512}) {
+    report(candidates);
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/value.hpp>
+#include <networkprotocoldsl_uv/asyncworkqueue.hpp>
+#include <networkprotocoldsl_uv/libuvserverwrapper.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <uv.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * Counts the write system calls the libuv loop thread makes for each
+ * HTTP response the server sends, a response being made of a dozen
+ * writes of the interpreter, with a client that waits for each
+ * response before sending the next request on the same connection.
+ */
+
+using namespace networkprotocoldsl;
+
+static value::Octets _o(const std::string &str) {
+  return value::Octets{std::make_shared<std::string>(str)};
+}
+
+// write, writev, sendmsg and the like the thread made so far.
+static std::uint64_t write_syscalls(pid_t tid) {
+  std::ifstream io("/proc/self/task/" + std::to_string(tid) + "/io");
+  std::string key;
+  std::uint64_t value;
+  while (io >> key >> value) {
+    if (key == "syscw:") {
+      return value;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const int requests = argc > 1 ? std::stoi(argv[1]) : 20000;
+
+  uv_loop_t *loop = uv_default_loop();
+  networkprotocoldsl_uv::AsyncWorkQueue async_queue(loop);
+  std::promise<pid_t> loop_tid;
+  std::thread io_thread([&]() {
+    loop_tid.set_value(syscall(SYS_gettid));
+    uv_run(loop, UV_RUN_DEFAULT);
+  });
+  pid_t tid = loop_tid.get_future().get();
+
+  auto program = InterpretedProgram::generate_server(
+      std::string(TEST_DATA_DIR) + "/023-source-code-http-client-server.txt");
+  if (!program.has_value()) {
+    std::cerr << "could not generate the server" << std::endl;
+    return 1;
+  }
+  InterpreterRunner::callback_map callbacks = {
+      {"AwaitResponse",
+       [](const std::vector<Value> &args) -> Value {
+         return value::DynamicList{
+             {_o("HTTP Response"),
+              value::Dictionary{
+                  {{"response_code", 200},
+                   {"reason_phrase", _o("OK")},
+                   {"major_version", 1},
+                   {"minor_version", 1},
+                   {"headers",
+                    value::DynamicList{
+                        {value::Dictionary{{{"key", _o("Content-Type")},
+                                            {"value", _o("text/plain")}}},
+                         value::Dictionary{
+                             {{"key", _o("Connection")},
+                              {"value", _o("keep-alive")}}}}}}}}}};
+       }},
+      {"Closed",
+       [](const std::vector<Value> &args) -> Value {
+         return value::DynamicList{{_o("N/A"), args.at(0)}};
+       }},
+  };
+  networkprotocoldsl_uv::LibuvServerWrapper server(*program, callbacks,
+                                                   async_queue);
+  auto bind_result = server.start("127.0.0.1", 0).get();
+  int port = std::get<networkprotocoldsl_uv::BindInfo>(bind_result).port;
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  // the port is known a moment before the server listens on it.
+  int fd = -1;
+  for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+      close(fd);
+      fd = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+  if (fd < 0) {
+    std::cerr << "could not connect" << std::endl;
+    return 1;
+  }
+
+  const std::string request = "GET /index.html HTTP/1.1\r\n"
+                              "Host: www.example.com\r\n"
+                              "\r\n";
+  std::uint64_t before = write_syscalls(tid);
+  auto start = std::chrono::steady_clock::now();
+  std::string received;
+  char buffer[4096];
+  for (int r = 0; r < requests; r++) {
+    send(fd, request.data(), request.size(), 0);
+    // a response ends with an empty line.
+    while (received.find("\r\n\r\n") == std::string::npos) {
+      ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        std::cerr << "connection closed" << std::endl;
+        return 1;
+      }
+      received.append(buffer, n);
+    }
+    received.erase(0, received.find("\r\n\r\n") + 4);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::uint64_t after = write_syscalls(tid);
+
+  std::cout << "responses: " << requests << " write syscalls per response: "
+            << static_cast<double>(after - before) / requests
+            << " responses per sec: "
+            << static_cast<std::uint64_t>(requests / elapsed.count())
+            << std::endl;
+
+  close(fd);
+  server.stop();
+  async_queue.shutdown().wait();
+  io_thread.join();
+  return 0;
+}
@@ -0,0 +1,15 @@
+#include <networkprotocoldsl/callbackregistry.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace networkprotocoldsl {
+
+std::size_t CallbackRegistry::resolve(const std::string &key) {
+  static std::mutex mtx;
+  static std::unordered_map<std::string, std::size_t> ids;
+  std::lock_guard<std::mutex> lk(mtx);
+  return ids.try_emplace(key, ids.size()).first->second;
+}
+
+} // namespace networkprotocoldsl
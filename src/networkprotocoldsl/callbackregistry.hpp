@@ -0,0 +1,35 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_CALLBACKREGISTRY_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_CALLBACKREGISTRY_HPP
+
+#include <cstddef>
+#include <limits>
+#include <string>
+
+namespace networkprotocoldsl {
+
+/**
+ * Gives every callback key a small integer id.
+ *
+ * The callback operations resolve their key when they are built, that
+ * is when the program is loaded, and the runner resolves the keys of
+ * the functions it was given once before running any of them. From
+ * then on a callback is found by indexing a vector with its id instead
+ * of hashing its key on every call.
+ *
+ * The ids are shared by every program in the process, and they are
+ * handed out in the order the keys are first seen.
+ */
+struct CallbackRegistry {
+  static constexpr std::size_t no_callback =
+      std::numeric_limits<std::size_t>::max();
+
+  /**
+   * The id of the key, which is assigned the first time it is asked
+   * for. Safe to call from any thread.
+   */
+  static std::size_t resolve(const std::string &key);
+};
+
+} // namespace networkprotocoldsl
+
+#endif
@@ -1,130 +1,226 @@
+#include <networkprotocoldsl/callbackregistry.hpp>
 #include <networkprotocoldsl/continuation.hpp>
+#include <networkprotocoldsl/trace.hpp>
 
+#include <array>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace networkprotocoldsl {
 
-template <typename O> static Value _get_callable(Continuation *c, const O &o) {
+template <typename O>
+static Value _get_callable(OperationContextVariant &ctx, const O &o) {
   return value::RuntimeError::TypeError;
 }
 
 template <ControlFlowOperationConcept O>
-static Value _get_callable(Continuation *c, const O &o) {
-  return o.get_callable(
-      std::get<ControlFlowOperationContext>(c->top().get_context()));
+static Value _get_callable(OperationContextVariant &ctx, const O &o) {
+  return o.get_callable(std::get<ControlFlowOperationContext>(ctx));
 }
 
 template <typename O>
 static std::shared_ptr<const std::vector<Value>>
-_get_argument_list(Continuation *c, const O &o) {
+_get_argument_list(OperationContextVariant &ctx, const O &o) {
   return std::make_shared<std::vector<Value>>();
 }
 
 template <ControlFlowOperationConcept O>
 static std::shared_ptr<const std::vector<Value>>
-_get_argument_list(Continuation *c, const O &o) {
-  return o.get_argument_list(
-      std::get<ControlFlowOperationContext>(c->top().get_context()));
+_get_argument_list(OperationContextVariant &ctx, const O &o) {
+  return o.get_argument_list(std::get<ControlFlowOperationContext>(ctx));
 }
 
 template <typename O>
-static void _set_callable_invoked(Continuation *c, const O &o) {}
+static void _set_callable_invoked(OperationContextVariant &ctx, const O &o) {}
 
 template <ControlFlowOperationConcept O>
-static void _set_callable_invoked(Continuation *c, const O &o) {
-  return o.set_callable_invoked(
-      std::get<ControlFlowOperationContext>(c->top().get_context()));
+static void _set_callable_invoked(OperationContextVariant &ctx, const O &o) {
+  return o.set_callable_invoked(std::get<ControlFlowOperationContext>(ctx));
 }
 
 template <typename O>
-static void _set_callable_return(Continuation *c, const O &o, Value v) {}
+static void _set_callable_return(OperationContextVariant &ctx, const O &o,
+                                 Value v) {}
 
 template <ControlFlowOperationConcept O>
-static void _set_callable_return(Continuation *c, const O &o, Value v) {
-  return o.set_callable_return(
-      std::get<ControlFlowOperationContext>(c->top().get_context()), v);
+static void _set_callable_return(OperationContextVariant &ctx, const O &o,
+                                 Value v) {
+  return o.set_callable_return(std::get<ControlFlowOperationContext>(ctx), v);
 }
 
 template <typename O>
-static std::string _get_callback_key(Continuation *c, const O &o) {
+static std::string _get_callback_key(OperationContextVariant &ctx, const O &o) {
   return "N/A";
 }
 
 template <CallbackOperationConcept O>
-static std::string _get_callback_key(Continuation *c, const O &o) {
-  return o.callback_key(
-      std::get<CallbackOperationContext>(c->top().get_context()));
+static std::string _get_callback_key(OperationContextVariant &ctx, const O &o) {
+  return o.callback_key(std::get<CallbackOperationContext>(ctx));
+}
+
+template <typename O>
+static std::size_t _get_callback_id(OperationContextVariant &ctx, const O &o) {
+  return CallbackRegistry::no_callback;
+}
+
+template <CallbackOperationConcept O>
+static std::size_t _get_callback_id(OperationContextVariant &ctx, const O &o) {
+  return o.callback_id(std::get<CallbackOperationContext>(ctx));
 }
 
 template <typename O>
-static void _set_callback_called(Continuation *c, const O &o) {}
+static void _set_callback_called(OperationContextVariant &ctx, const O &o) {}
 
 template <CallbackOperationConcept O>
-static void _set_callback_called(Continuation *c, const O &o) {
-  o.set_callback_called(
-      std::get<CallbackOperationContext>(c->top().get_context()));
+static void _set_callback_called(OperationContextVariant &ctx, const O &o) {
+  o.set_callback_called(std::get<CallbackOperationContext>(ctx));
 }
 
 template <typename O>
-static void _set_callback_return(Continuation *c, const O &o, Value v) {}
+static void _set_callback_return(OperationContextVariant &ctx, const O &o,
+                                 Value v) {}
 
 template <CallbackOperationConcept O>
-static void _set_callback_return(Continuation *c, const O &o, Value v) {
-  o.set_callback_return(
-      std::get<CallbackOperationContext>(c->top().get_context()), v);
+static void _set_callback_return(OperationContextVariant &ctx, const O &o,
+                                 Value v) {
+  o.set_callback_return(std::get<CallbackOperationContext>(ctx), v);
 }
 
 template <typename O>
-static size_t _handle_read(Continuation *c, const O &o, std::string_view s) {
+static size_t _handle_read(OperationContextVariant &ctx, const O &o,
+                           std::string_view s) {
   return 0;
 }
 
 template <InputOutputOperationConcept O>
-static size_t _handle_read(Continuation *c, const O &o, std::string_view s) {
-  return o.handle_read(
-      std::get<InputOutputOperationContext>(c->top().get_context()), s);
+static size_t _handle_read(OperationContextVariant &ctx, const O &o,
+                           std::string_view s) {
+  return o.handle_read(std::get<InputOutputOperationContext>(ctx), s);
 }
 
-template <typename O> static void _handle_eof(Continuation *c, const O &o) {}
+template <typename O>
+static void _handle_eof(OperationContextVariant &ctx, const O &o) {}
 
 template <InputOutputOperationConcept O>
-static void _handle_eof(Continuation *c, const O &o) {
-  o.handle_eof(std::get<InputOutputOperationContext>(c->top().get_context()));
+static void _handle_eof(OperationContextVariant &ctx, const O &o) {
+  o.handle_eof(std::get<InputOutputOperationContext>(ctx));
 }
 
 template <typename O>
-static std::string_view _get_write_buffer(Continuation *c, const O &o) {
+static std::string_view _get_write_buffer(OperationContextVariant &ctx,
+                                          const O &o) {
   return std::string_view();
 }
 
 template <InputOutputOperationConcept O>
-static std::string_view _get_write_buffer(Continuation *c, const O &o) {
-  return o.get_write_buffer(
-      std::get<InputOutputOperationContext>(c->top().get_context()));
+static std::string_view _get_write_buffer(OperationContextVariant &ctx,
+                                          const O &o) {
+  return o.get_write_buffer(std::get<InputOutputOperationContext>(ctx));
+}
+
+template <typename O>
+static value::Octets _get_write_octets(OperationContextVariant &ctx,
+                                       const O &o) {
+  return value::Octets();
+}
+
+template <InputOutputOperationConcept O>
+static value::Octets _get_write_octets(OperationContextVariant &ctx,
+                                       const O &o) {
+  return value::Octets(std::string(
+      o.get_write_buffer(std::get<InputOutputOperationContext>(ctx))));
+}
+
+template <OctetsOutputOperationConcept O>
+static value::Octets _get_write_octets(OperationContextVariant &ctx,
+                                       const O &o) {
+  return o.get_write_octets(std::get<InputOutputOperationContext>(ctx));
 }
 
 template <typename O>
-static size_t _handle_write(Continuation *c, const O &o, size_t s) {
+static size_t _handle_write(OperationContextVariant &ctx, const O &o,
+                            size_t s) {
   return 0;
 }
 
 template <InputOutputOperationConcept O>
-static size_t _handle_write(Continuation *c, const O &o, size_t s) {
-  return o.handle_write(
-      std::get<InputOutputOperationContext>(c->top().get_context()), s);
+static size_t _handle_write(OperationContextVariant &ctx, const O &o,
+                            size_t s) {
+  return o.handle_write(std::get<InputOutputOperationContext>(ctx), s);
 }
 
 template <typename O>
-static bool _ready_to_evaluate(Continuation *c, const O &o) {
+static bool _ready_to_evaluate(OperationContextVariant &ctx, const O &o) {
   // Non-I/O operations are always ready
   return true;
 }
 
 template <InputOutputOperationConcept O>
-static bool _ready_to_evaluate(Continuation *c, const O &o) {
-  return o.ready_to_evaluate(
-      std::get<InputOutputOperationContext>(c->top().get_context()));
+static bool _ready_to_evaluate(OperationContextVariant &ctx, const O &o) {
+  return o.ready_to_evaluate(std::get<InputOutputOperationContext>(ctx));
+}
+
+template <typename O> static constexpr ContinuationHooks make_hooks() {
+  return ContinuationHooks{
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_callable(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_argument_list(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        _set_callable_invoked(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx, Value v) {
+        _set_callable_return(ctx, *std::get_if<O>(&op), v);
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_callback_key(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_callback_id(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        _set_callback_called(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx, Value v) {
+        _set_callback_return(ctx, *std::get_if<O>(&op), v);
+      },
+      [](const Operation &op, OperationContextVariant &ctx,
+         std::string_view in) {
+        return _handle_read(ctx, *std::get_if<O>(&op), in);
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        _handle_eof(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_write_buffer(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _get_write_octets(ctx, *std::get_if<O>(&op));
+      },
+      [](const Operation &op, OperationContextVariant &ctx, size_t s) {
+        return _handle_write(ctx, *std::get_if<O>(&op), s);
+      },
+      [](const Operation &op, OperationContextVariant &ctx) {
+        return _ready_to_evaluate(ctx, *std::get_if<O>(&op));
+      },
+  };
+}
+
+template <std::size_t... Indices>
+static constexpr std::array<ContinuationHooks, sizeof...(Indices)>
+make_hooks_table(std::index_sequence<Indices...>) {
+  return {make_hooks<std::variant_alternative_t<Indices, Operation>>()...};
+}
+
+static constexpr auto hooks_table = make_hooks_table(
+    std::make_index_sequence<std::variant_size_v<Operation>>());
+
+const ContinuationHooks &ContinuationHooks::for_operation(const Operation &op) {
+  return hooks_table[op.index()];
 }
 
 static ContinuationState map_result_to_state(Value v) {
@@ -136,23 +232,68 @@ static ContinuationState map_result_to_state(ReasonForBlockedOperation r) {
 }
 
 Continuation::Continuation(std::shared_ptr<const OpTree> ot,
-                           std::shared_ptr<LexicalPad> p) {
-  optree = ot;
-  pad = p;
-  stack.push(ExecutionStackFrame(optree->root, pad));
+                           std::shared_ptr<LexicalPad> p,
+                           std::pmr::memory_resource *resource)
+    : frames(resource), registers(resource) {
+  reset(std::move(ot), std::move(p));
+}
+
+void Continuation::reset(std::shared_ptr<const OpTree> ot,
+                         std::shared_ptr<LexicalPad> p) {
+  frames.clear();
+  registers.clear();
+  optree = std::move(ot);
+  pad = std::move(p);
+  state = ContinuationState::MissingArguments;
+  result = false;
+  frames.reserve(optree->max_depth);
+  registers.reserve(optree->max_registers);
+  frames.emplace_back(&optree->instructions.front(), 0);
+}
+
+void Continuation::release() {
+  frames.clear();
+  registers.clear();
+  optree.reset();
+  pad.reset();
+  result = false;
+}
+
+bool Continuation::in_tail_position() const {
+  // FunctionCall and If return whatever the callable returns...
+  const Operation &op = frames.back().get_operation();
+  if (!std::holds_alternative<operation::FunctionCall>(op) &&
+      !std::holds_alternative<operation::If>(op)) {
+    return false;
+  }
+  // ...and so does an OpSequence that is running its last element.
+  for (std::size_t i = frames.size() - 1; i > 0; i--) {
+    const ExecutionStackFrame &parent = frames[i - 1];
+    if (!std::holds_alternative<operation::OpSequence>(
+            parent.get_operation()) ||
+        parent.get_arguments(registers).size() + 1 !=
+            parent.get_children_count()) {
+      return false;
+    }
+  }
+  return true;
 }
 
-ExecutionStackFrame &Continuation::top() { return stack.top(); }
+ExecutionStackFrame &Continuation::top() { return frames.back(); }
+
+const ContinuationHooks &Continuation::hooks() {
+  return *frames.back().get_instruction().continuation_hooks;
+}
 
 ContinuationState Continuation::result_to_state() {
   return std::visit([](auto &r) { return map_result_to_state(r); }, result);
 }
 
 ContinuationState Continuation::prepare() {
-  if (stack.size()) {
-    while (!stack.top().has_arguments_ready()) {
-      stack.push(
-          ExecutionStackFrame(stack.top().next_op(), stack.top().get_pad()));
+  if (frames.size()) {
+    while (!frames.back().has_arguments_ready(registers)) {
+      std::size_t next = frames.back().next_op(registers);
+      frames.emplace_back(&optree->instructions[next], registers.size());
     }
     return ContinuationState::Ready;
   } else {
@@ -165,12 +306,16 @@ std::shared_ptr<LexicalPad> Continuation::get_pad() { return pad; }
 ContinuationState Continuation::step() {
   state = prepare();
   if (state == ContinuationState::Ready) {
-    result = stack.top().execute();
+    NETWORKPROTOCOLDSL_TRACE_OPERATION(trace_tag,
+                                       frames.back().get_operation().index());
+    result = frames.back().execute(registers, pad);
     state = result_to_state();
     if (state == ContinuationState::Ready) {
-      stack.pop();
-      if (stack.size()) {
-        stack.top().push_back(std::get<Value>(result));
+      registers.erase(registers.begin() + frames.back().get_arguments_base(),
+                      registers.end());
+      frames.pop_back();
+      if (frames.size()) {
+        registers.push_back(std::get<Value>(result));
       } else {
         state = ContinuationState::Exited;
       }
@@ -179,71 +324,89 @@ ContinuationState Continuation::step() {
   return state;
 }
 
+void Continuation::set_trace_tag(int tag) { trace_tag = tag; }
+
 OperationResult Continuation::get_result() { return result; }
 
 std::string Continuation::get_callback_key() {
-  return std::visit([this](auto &o) { return _get_callback_key(this, o); },
-                    stack.top().get_operation());
+  return hooks().get_callback_key(top().get_operation(), top().get_context());
+}
+
+std::size_t Continuation::get_callback_id() {
+  return hooks().get_callback_id(top().get_operation(), top().get_context());
 }
 
 void Continuation::set_callback_called() {
-  std::visit([this](auto &o) { return _set_callback_called(this, o); },
-             stack.top().get_operation());
+  hooks().set_callback_called(top().get_operation(), top().get_context());
+}
+
+std::vector<Value> Continuation::get_callback_arguments() {
+  std::span<const Value> args = frames.back().get_arguments(registers);
+  return std::vector<Value>(args.begin(), args.end());
 }
 
-const std::vector<Value> &Continuation::get_callback_arguments() {
-  return *(stack.top().get_accumulator());
+std::vector<Value> Continuation::take_callback_arguments() {
+  auto first = registers.begin() + frames.back().get_arguments_base();
+  return std::vector<Value>(std::make_move_iterator(first),
+                            std::make_move_iterator(registers.end()));
 }
 
 void Continuation::set_callback_return(Value v) {
-  std::visit([this, v](auto &o) { _set_callback_return(this, o, v); },
-             stack.top().get_operation());
+  hooks().set_callback_return(top().get_operation(), top().get_context(), v);
 }
 
 size_t Continuation::handle_read(std::string_view in) {
-  return std::visit([this, in](auto &o) { return _handle_read(this, o, in); },
-                    stack.top().get_operation());
+  return hooks().handle_read(top().get_operation(), top().get_context(), in);
+}
+
+size_t Continuation::handle_read(const std::shared_ptr<const std::string> &in,
+                                 std::size_t offset) {
+  auto *io = std::get_if<InputOutputOperationContext>(&top().get_context());
+  if (!io) {
+    return handle_read(std::string_view(*in).substr(offset));
+  }
+  io->input = in;
+  size_t consumed = handle_read(std::string_view(*in).substr(offset));
+  // the buffer is only kept alive by the slices taken from it.
+  io->input.reset();
+  return consumed;
 }
 
 std::string_view Continuation::get_write_buffer() {
-  return std::visit([this](auto &o) { return _get_write_buffer(this, o); },
-                    stack.top().get_operation());
+  return hooks().get_write_buffer(top().get_operation(), top().get_context());
+}
+
+value::Octets Continuation::get_write_octets() {
+  return hooks().get_write_octets(top().get_operation(), top().get_context());
 }
 
 size_t Continuation::handle_write(size_t s) {
-  return std::visit([this, s](auto &o) { return _handle_write(this, o, s); },
-                    stack.top().get_operation());
+  return hooks().handle_write(top().get_operation(), top().get_context(), s);
 }
 
 bool Continuation::ready_to_evaluate() {
-  return std::visit([this](auto &o) { return _ready_to_evaluate(this, o); },
-                    stack.top().get_operation());
+  return hooks().ready_to_evaluate(top().get_operation(), top().get_context());
 }
 
 Value Continuation::get_callable() {
-  return std::visit([this](auto &o) { return _get_callable(this, o); },
-                    stack.top().get_operation());
+  return hooks().get_callable(top().get_operation(), top().get_context());
 }
 
 std::shared_ptr<const std::vector<Value>> Continuation::get_argument_list() {
-  return std::visit([this](auto &o) { return _get_argument_list(this, o); },
-                    stack.top().get_operation());
+  return hooks().get_argument_list(top().get_operation(), top().get_context());
 }
 
 void Continuation::set_callable_invoked() {
-  std::visit([this](auto &o) { _set_callable_invoked(this, o); },
-             stack.top().get_operation());
+  hooks().set_callable_invoked(top().get_operation(), top().get_context());
 }
 
 void Continuation::set_callable_return(Value v) {
   result = v;
-  std::visit([this, &v](auto &o) { _set_callable_return(this, o, v); },
-             stack.top().get_operation());
+  hooks().set_callable_return(top().get_operation(), top().get_context(), v);
 }
 
 void Continuation::handle_eof() {
-  std::visit([this](auto &o) { _handle_eof(this, o); },
-             stack.top().get_operation());
+  hooks().handle_eof(top().get_operation(), top().get_context());
 }
 
 }; // namespace networkprotocoldsl
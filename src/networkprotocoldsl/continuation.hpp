@@ -4,7 +4,10 @@
 #include <networkprotocoldsl/executionstackframe.hpp>
 
 #include <memory>
-#include <stack>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace networkprotocoldsl {
 
@@ -14,24 +17,91 @@ namespace networkprotocoldsl {
  */
 enum class ContinuationState { MissingArguments, Ready, Blocked, Exited };
 
+/**
+ * The operation-specific parts of the continuation interface used by
+ * the interpreter and the runners, such as reading, writing and
+ * invoking callables. Like FrameHooks, there is one table per
+ * alternative of Operation and each instruction points to its own.
+ */
+struct ContinuationHooks {
+  Value (*get_callable)(const Operation &op, OperationContextVariant &ctx);
+  std::shared_ptr<const std::vector<Value>> (*get_argument_list)(
+      const Operation &op, OperationContextVariant &ctx);
+  void (*set_callable_invoked)(const Operation &op,
+                               OperationContextVariant &ctx);
+  void (*set_callable_return)(const Operation &op,
+                              OperationContextVariant &ctx, Value v);
+  std::string (*get_callback_key)(const Operation &op,
+                                  OperationContextVariant &ctx);
+  std::size_t (*get_callback_id)(const Operation &op,
+                                 OperationContextVariant &ctx);
+  void (*set_callback_called)(const Operation &op,
+                              OperationContextVariant &ctx);
+  void (*set_callback_return)(const Operation &op,
+                              OperationContextVariant &ctx, Value v);
+  size_t (*handle_read)(const Operation &op, OperationContextVariant &ctx,
+                        std::string_view in);
+  void (*handle_eof)(const Operation &op, OperationContextVariant &ctx);
+  std::string_view (*get_write_buffer)(const Operation &op,
+                                       OperationContextVariant &ctx);
+  value::Octets (*get_write_octets)(const Operation &op,
+                                    OperationContextVariant &ctx);
+  size_t (*handle_write)(const Operation &op, OperationContextVariant &ctx,
+                         size_t s);
+  bool (*ready_to_evaluate)(const Operation &op, OperationContextVariant &ctx);
+
+  static const ContinuationHooks &for_operation(const Operation &op);
+};
+
 /**
  * A continuation represents the state of a single thread of execution
  * within a intepreter. The interpreter may have many of those
  * running.
+ *
+ * The continuation walks the lowered instructions of the OpTree. The
+ * frames and the register file holding the inputs of those frames
+ * are sized for the program when the continuation is created, so
+ * stepping through the program does not allocate per operation.
+ * Both are drawn from the given memory resource, which is the arena
+ * of the interpreter for the continuations of invoked callables.
  */
 class Continuation {
   std::shared_ptr<const OpTree> optree;
-  std::stack<ExecutionStackFrame> stack;
+  std::pmr::vector<ExecutionStackFrame> frames;
+  RegisterFile registers;
   std::shared_ptr<LexicalPad> pad;
   ContinuationState state = ContinuationState::MissingArguments;
   OperationResult result = false;
+  int trace_tag = -1;
+
+  const ContinuationHooks &hooks();
 
 public:
-  Continuation(std::shared_ptr<const OpTree> ot,
-               std::shared_ptr<LexicalPad> pad);
+  Continuation(
+      std::shared_ptr<const OpTree> ot, std::shared_ptr<LexicalPad> pad,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
   ExecutionStackFrame &top();
 
+  /**
+   * Starts running another tree on this continuation, keeping the
+   * storage of its frames and registers.
+   */
+  void reset(std::shared_ptr<const OpTree> ot, std::shared_ptr<LexicalPad> pad);
+
+  /**
+   * Drops the tree and the pad, so a continuation that is kept
+   * around to be reset later does not hold on to them.
+   */
+  void release();
+
+  /**
+   * Whether the operation at the top is a call whose result becomes
+   * the result of the whole continuation. The callee can then run in
+   * place of the continuation instead of on top of it.
+   */
+  bool in_tail_position() const;
+
   ContinuationState result_to_state();
 
   ContinuationState prepare();
@@ -40,6 +110,8 @@ public:
 
   ContinuationState step();
 
+  void set_trace_tag(int tag);
+
   OperationResult get_result();
 
   Value get_callable();
@@ -52,15 +124,34 @@ public:
 
   std::string get_callback_key();
 
+  std::size_t get_callback_id();
+
   void set_callback_called();
 
-  const std::vector<Value> &get_callback_arguments();
+  std::vector<Value> get_callback_arguments();
+
+  /**
+   * Moves the arguments out instead of copying them. The operation
+   * doesn't look at them again once the callback was called, so this
+   * is what the runner uses.
+   */
+  std::vector<Value> take_callback_arguments();
 
   void set_callback_return(Value v);
 
   size_t handle_read(std::string_view in);
 
+  /**
+   * Like handle_read on a view of the buffer from offset on, but lets
+   * the operation keep a slice of it instead of copying what it reads.
+   */
+  size_t handle_read(const std::shared_ptr<const std::string> &in,
+                     std::size_t offset = 0);
+
   std::string_view get_write_buffer();
+  // the same bytes, sharing storage with the operation or the value
+  // being written when it can.
+  value::Octets get_write_octets();
 
   size_t handle_write(size_t s);
 
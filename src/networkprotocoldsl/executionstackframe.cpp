@@ -1,18 +1,16 @@
 #include <networkprotocoldsl/executionstackframe.hpp>
 #include <networkprotocoldsl/operationconcepts.hpp>
-#include <networkprotocoldsl/print_optreenode.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <array>
 #include <cassert>
-#include <fstream>
-#include <iostream>
 #include <memory>
-#include <thread>
+#include <utility>
 
 namespace networkprotocoldsl {
 
 template <std::size_t... Indices>
-static auto make_argument_tuple(const std::vector<Value> &v,
+static auto make_argument_tuple(std::span<const Value> v,
                                 std::index_sequence<Indices...>) {
   return std::make_tuple(v[Indices]...);
 }
@@ -48,10 +46,10 @@ static OperationContextVariant initialize_context(const O &o) {
 }
 
 template <OperationConcept O>
-static bool operation_has_arguments_ready(ExecutionStackFrame *frame,
+static bool operation_has_arguments_ready(std::span<const Value> args,
+                                          std::size_t children_count,
                                           const O &o) {
-  if (frame->get_accumulator()->size() <
-      std::tuple_size<typename O::Arguments>::value) {
+  if (args.size() < std::tuple_size<typename O::Arguments>::value) {
     return false;
   } else {
     return true;
@@ -59,14 +57,14 @@ static bool operation_has_arguments_ready(ExecutionStackFrame *frame,
 }
 
 template <DynamicInputOperationConcept O>
-static bool operation_has_arguments_ready(ExecutionStackFrame *frame,
+static bool operation_has_arguments_ready(std::span<const Value> args,
+                                          std::size_t children_count,
                                           const O &o) {
-  std::shared_ptr<std::vector<Value>> acc = frame->get_accumulator();
-  if (acc->size() > 0 &&
-      (std::holds_alternative<value::RuntimeError>(acc->back()) ||
-       std::holds_alternative<value::ControlFlowInstruction>(acc->back()))) {
+  if (args.size() > 0 &&
+      (std::holds_alternative<value::RuntimeError>(args.back()) ||
+       std::holds_alternative<value::ControlFlowInstruction>(args.back()))) {
     return true;
-  } else if (acc->size() < frame->get_children_count()) {
+  } else if (args.size() < children_count) {
     return false;
   } else {
     return true;
@@ -74,121 +72,154 @@ static bool operation_has_arguments_ready(ExecutionStackFrame *frame,
 }
 
 template <InterpretedOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
   typename O::Arguments args(make_argument_tuple(
-      *(frame->get_accumulator()),
-      std::make_index_sequence<
-          std::tuple_size<typename O::Arguments>::value>()));
+      arguments, std::make_index_sequence<
+                     std::tuple_size<typename O::Arguments>::value>()));
   return o(args);
 }
 
 template <CallbackOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
   typename O::Arguments args(make_argument_tuple(
-      *(frame->get_accumulator()),
-      std::make_index_sequence<
-          std::tuple_size<typename O::Arguments>::value>()));
-  return o(std::get<CallbackOperationContext>(frame->get_context()), args);
+      arguments, std::make_index_sequence<
+                     std::tuple_size<typename O::Arguments>::value>()));
+  return o(std::get<CallbackOperationContext>(ctx), args);
 }
 
 template <ControlFlowOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
   typename O::Arguments args(make_argument_tuple(
-      *(frame->get_accumulator()),
-      std::make_index_sequence<
-          std::tuple_size<typename O::Arguments>::value>()));
-  return o(std::get<ControlFlowOperationContext>(frame->get_context()), args);
+      arguments, std::make_index_sequence<
+                     std::tuple_size<typename O::Arguments>::value>()));
+  return o(std::get<ControlFlowOperationContext>(ctx), args);
 }
 
 template <InputOutputOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
   typename O::Arguments args(make_argument_tuple(
-      *(frame->get_accumulator()),
-      std::make_index_sequence<
-          std::tuple_size<typename O::Arguments>::value>()));
-  return o(std::get<InputOutputOperationContext>(frame->get_context()), args);
+      arguments, std::make_index_sequence<
+                     std::tuple_size<typename O::Arguments>::value>()));
+  return o(std::get<InputOutputOperationContext>(ctx), args);
 }
 
 template <LexicalPadOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
   typename O::Arguments args(make_argument_tuple(
-      *(frame->get_accumulator()),
-      std::make_index_sequence<
-          std::tuple_size<typename O::Arguments>::value>()));
-  return o(args, frame->get_pad());
+      arguments, std::make_index_sequence<
+                     std::tuple_size<typename O::Arguments>::value>()));
+  return o(args, pad);
 }
 
 template <DynamicInputOperationConcept O>
-static OperationResult execute_specific_operation(ExecutionStackFrame *frame,
-                                                  const O &o) {
-  return o(frame->get_accumulator());
+static OperationResult
+execute_specific_operation(std::span<const Value> arguments,
+                           OperationContextVariant &ctx,
+                           const std::shared_ptr<LexicalPad> &pad, const O &o) {
+  return o(arguments);
+}
+
+template <typename O> static constexpr FrameHooks make_frame_hooks() {
+  return FrameHooks{
+      [](const Operation &op) {
+        return initialize_context(*std::get_if<O>(&op));
+      },
+      [](const Operation &op, std::span<const Value> args,
+         std::size_t children_count) {
+        return operation_has_arguments_ready(args, children_count,
+                                             *std::get_if<O>(&op));
+      },
+      [](const Operation &op, std::span<const Value> args,
+         OperationContextVariant &ctx, const std::shared_ptr<LexicalPad> &pad) {
+        return execute_specific_operation(args, ctx, pad,
+                                          *std::get_if<O>(&op));
+      },
+  };
 }
 
-ExecutionStackFrame::ExecutionStackFrame(const OpTreeNode &o,
-                                         std::shared_ptr<LexicalPad> p)
-    : optreenode(o), pad(p) {
-  ctx = std::visit([](auto &o) { return initialize_context(o); },
-                   optreenode.operation);
-  accumulator = std::make_shared<std::vector<Value>>();
+template <std::size_t... Indices>
+static constexpr std::array<FrameHooks, sizeof...(Indices)>
+make_frame_hooks_table(std::index_sequence<Indices...>) {
+  return {
+      make_frame_hooks<std::variant_alternative_t<Indices, Operation>>()...};
 }
 
-bool ExecutionStackFrame::has_arguments_ready() {
-  return std::visit(
-      [this](auto &o) { return operation_has_arguments_ready(this, o); },
-      optreenode.operation);
-}
+static constexpr auto frame_hooks_table = make_frame_hooks_table(
+    std::make_index_sequence<std::variant_size_v<Operation>>());
 
-std::shared_ptr<LexicalPad> ExecutionStackFrame::get_pad() { return pad; }
+const FrameHooks &FrameHooks::for_operation(const Operation &op) {
+  return frame_hooks_table[op.index()];
+}
 
-static std::string get_debug_stream_file_name() {
-  std::thread::id this_id = std::this_thread::get_id();
-  std::ostringstream ss;
-  ss << "/tmp/thread_";
-  ss << this_id;
-  ss << "_debug.log";
-  return ss.str();
+ExecutionStackFrame::ExecutionStackFrame(const OpTreeInstruction *i,
+                                         std::size_t base)
+    : instruction(i), arguments_base(base) {
+  ctx = instruction->frame_hooks->initialize_context(*instruction->operation);
 }
 
-static void do_debug(ExecutionStackFrame *frame) {
-  thread_local static std::ofstream debug_file(get_debug_stream_file_name(),
-                                               std::ios_base::app);
-  print_optreenode(frame->optreenode, debug_file, ">  ", "| ");
+bool ExecutionStackFrame::has_arguments_ready(
+    const RegisterFile &registers) const {
+  return instruction->frame_hooks->has_arguments_ready(
+      *instruction->operation, get_arguments(registers),
+      instruction->children_count);
 }
 
-OperationResult ExecutionStackFrame::execute() {
-  assert(has_arguments_ready());
+OperationResult
+ExecutionStackFrame::execute(const RegisterFile &registers,
+                             const std::shared_ptr<LexicalPad> &pad) {
+  assert(has_arguments_ready(registers));
+  return instruction->frame_hooks->execute(
+      *instruction->operation, get_arguments(registers), ctx, pad);
+}
 
-  do_debug(this);
-  return std::visit(
-      [this](auto &o) { return execute_specific_operation(this, o); },
-      optreenode.operation);
+std::size_t
+ExecutionStackFrame::next_op(const RegisterFile &registers) const {
+  assert(!has_arguments_ready(registers));
+  std::size_t accumulated = registers.size() - arguments_base;
+  assert(accumulated < instruction->children_count);
+  return instruction->first_child + accumulated;
 }
 
-void ExecutionStackFrame::push_back(Value v) { accumulator->push_back(v); }
+const Operation &ExecutionStackFrame::get_operation() const {
+  return *instruction->operation;
+}
 
-const OpTreeNode &ExecutionStackFrame::next_op() {
-  assert(!has_arguments_ready());
-  assert(accumulator->size() < optreenode.children.size());
-  return optreenode.children[accumulator->size()];
+const OpTreeInstruction &ExecutionStackFrame::get_instruction() const {
+  return *instruction;
 }
 
-const Operation &ExecutionStackFrame::get_operation() {
-  return optreenode.operation;
+const OpTreeNode &ExecutionStackFrame::get_node() const {
+  return *instruction->node;
 }
 
-size_t ExecutionStackFrame::get_children_count() {
-  return optreenode.children.size();
+size_t ExecutionStackFrame::get_children_count() const {
+  return instruction->children_count;
 }
 
-OperationContextVariant &ExecutionStackFrame::get_context() { return ctx; }
+std::size_t ExecutionStackFrame::get_arguments_base() const {
+  return arguments_base;
+}
 
-std::shared_ptr<std::vector<Value>> ExecutionStackFrame::get_accumulator() {
-  return accumulator;
+std::span<const Value>
+ExecutionStackFrame::get_arguments(const RegisterFile &registers) const {
+  return std::span<const Value>(registers).subspan(arguments_base);
 }
 
+OperationContextVariant &ExecutionStackFrame::get_context() { return ctx; }
+
 } // namespace networkprotocoldsl
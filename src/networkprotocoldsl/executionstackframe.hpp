@@ -6,7 +6,9 @@
 #include <networkprotocoldsl/optree.hpp>
 
 #include <cstdint>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
 #include <tuple>
 
@@ -17,39 +19,67 @@ using OperationContextVariant =
                  InputOutputOperationContext>;
 
 /**
- * The execution frame points to a specific operation and the
+ * The values accumulated by the frames of a continuation.
+ */
+using RegisterFile = std::pmr::vector<Value>;
+
+/**
+ * The operation-specific steps of running a frame. One table exists
+ * per alternative of Operation, built from the concept dispatch in
+ * executionstackframe.cpp, and every instruction points to the table
+ * of its operation when the OpTree is lowered. Running a frame is
+ * then an indirect call instead of a std::visit.
+ */
+struct FrameHooks {
+  OperationContextVariant (*initialize_context)(const Operation &op);
+  bool (*has_arguments_ready)(const Operation &op, std::span<const Value> args,
+                              std::size_t children_count);
+  OperationResult (*execute)(const Operation &op, std::span<const Value> args,
+                             OperationContextVariant &ctx,
+                             const std::shared_ptr<LexicalPad> &pad);
+
+  static const FrameHooks &for_operation(const Operation &op);
+};
+
+/**
+ * The execution frame points to a specific instruction and the
  * accumulation of inputs for that operation. The actual operation can
  * only happen when the right number of inputs has been provided.
+ *
+ * The frame does not own its inputs. The continuation keeps a single
+ * register file, and the inputs of the frame are the values from
+ * arguments_base to the end of it, since only the innermost frame
+ * is ever accumulating values.
  */
 class ExecutionStackFrame {
-public:
-  const OpTreeNode &optreenode;
-
-private:
-  std::shared_ptr<std::vector<Value>> accumulator;
+  const OpTreeInstruction *instruction;
+  std::size_t arguments_base;
   OperationContextVariant ctx;
-  std::shared_ptr<LexicalPad> pad;
 
 public:
-  ExecutionStackFrame(const OpTreeNode &o, std::shared_ptr<LexicalPad> pad);
+  ExecutionStackFrame(const OpTreeInstruction *i, std::size_t base);
 
-  bool has_arguments_ready();
+  bool has_arguments_ready(const RegisterFile &registers) const;
 
-  OperationResult execute();
+  OperationResult execute(const RegisterFile &registers,
+                          const std::shared_ptr<LexicalPad> &pad);
 
-  void push_back(Value v);
+  std::size_t next_op(const RegisterFile &registers) const;
 
-  const OpTreeNode &next_op();
+  const Operation &get_operation() const;
 
-  std::shared_ptr<LexicalPad> get_pad();
+  const OpTreeInstruction &get_instruction() const;
 
-  const Operation &get_operation();
+  const OpTreeNode &get_node() const;
 
-  size_t get_children_count();
+  size_t get_children_count() const;
 
-  OperationContextVariant &get_context();
+  std::size_t get_arguments_base() const;
+
+  std::span<const Value>
+  get_arguments(const RegisterFile &registers) const;
 
-  std::shared_ptr<std::vector<Value>> get_accumulator();
+  OperationContextVariant &get_context();
 };
 
 } // namespace networkprotocoldsl
@@ -436,21 +436,23 @@ get_transition_condition(
 
 static std::optional<std::shared_ptr<const OpTree>>
 generate_read_state_callback(
-    const std::shared_ptr<const sema::ast::State> &state) {
-  std::vector<std::pair<operation::TransitionLookahead::TransitionCondition,
-                        std::string>>
+    const std::shared_ptr<const sema::ast::State> &state,
+    const StateMachineOperation::TransitionIds &transition_ids) {
+  std::vector<
+      std::pair<operation::TransitionLookahead::TransitionCondition, int32_t>>
       conditions;
   for (const auto &transition_pair : state->transitions) {
     const auto &transition = transition_pair.second.first;
     const auto &target_state = transition_pair.second.second;
+    int32_t transition_id = transition_ids.at(transition_pair.first);
     if (target_state == "Closed") {
       conditions.emplace_back(operation::TransitionLookahead::EOFCondition{},
-                              transition_pair.first);
+                              transition_id);
     } else {
       auto maybe_condition = std::visit(
           [](auto &t) { return get_transition_condition(t); }, transition);
       if (maybe_condition) {
-        conditions.emplace_back(*maybe_condition, transition_pair.first);
+        conditions.emplace_back(*maybe_condition, transition_id);
       } else {
         return std::nullopt;
       }
@@ -465,6 +467,93 @@ generate_read_state_callback(
                   {operation::LexicalPadGet{"dictionary"}, {}}}});
 }
 
+using PadScopes = std::vector<std::shared_ptr<const LexicalPadLayout>>;
+
+static std::optional<LexicalPadSlot> find_pad_slot(const PadScopes &scopes,
+                                                   std::size_t max_depth,
+                                                   const std::string &name) {
+  for (std::size_t depth = 0; depth < scopes.size() && depth < max_depth;
+       depth++) {
+    const auto &layout = *scopes[depth];
+    for (std::size_t slot = 0; slot < layout.size(); slot++) {
+      if (layout[slot] == name) {
+        return LexicalPadSlot{depth, slot};
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+static std::shared_ptr<OpTree>
+resolve_lexical_pads(const std::shared_ptr<const OpTree> &optree,
+                     const std::vector<std::string> &argument_names,
+                     const PadScopes &enclosing);
+
+static Operation resolve_operation(const LexicalPadGet &op,
+                                   const PadScopes &scopes) {
+  auto slot = find_pad_slot(scopes, scopes.size(), op.get_name());
+  return slot ? Operation{LexicalPadGet(op.get_name(), *slot)} : op;
+}
+
+static Operation resolve_operation(const LexicalPadSet &op,
+                                   const PadScopes &scopes) {
+  auto slot = find_pad_slot(scopes, scopes.size(), op.get_name());
+  return slot ? Operation{LexicalPadSet(op.get_name(), *slot)} : op;
+}
+
+static Operation resolve_operation(const LexicalPadInitialize &op,
+                                   const PadScopes &scopes) {
+  // initialization always targets the pad of the running callable.
+  auto slot = find_pad_slot(scopes, 1, op.get_name());
+  return slot ? Operation{LexicalPadInitialize(op.get_name(), *slot)} : op;
+}
+
+static Operation resolve_operation(const StaticCallable &op,
+                                   const PadScopes &scopes) {
+  // a callable that does not inherit the pad only sees its own
+  // variables, anything else is left to the by-name lookup.
+  PadScopes enclosing = op.get_inherits_lexical_pad() ? scopes : PadScopes{};
+  return StaticCallable(resolve_lexical_pads(op.get_optree(),
+                                             op.get_argument_names(),
+                                             enclosing),
+                        op.get_argument_names(), op.get_inherits_lexical_pad());
+}
+
+static Operation resolve_operation(const auto &op, const PadScopes &) {
+  return op;
+}
+
+static OpTreeNode resolve_lexical_pads(const OpTreeNode &node,
+                                       const PadScopes &scopes) {
+  std::vector<OpTreeNode> children;
+  children.reserve(node.children.size());
+  for (const auto &child : node.children) {
+    children.push_back(resolve_lexical_pads(child, scopes));
+  }
+  return OpTreeNode{
+      std::visit([&](const auto &op) { return resolve_operation(op, scopes); },
+                 node.operation),
+      children};
+}
+
+/**
+ * Rewrites the lexical pad operations of a callable so they address
+ * the slots of the pads directly. The scopes are the layouts of the
+ * pads visible from the callable, innermost first, which matches the
+ * chain of parents at runtime since every nested callable in the
+ * generated code inherits the pad it is invoked from. Names that are
+ * not declared in any of them, such as the ones provided by the root
+ * pad, keep being looked up by name.
+ */
+static std::shared_ptr<OpTree>
+resolve_lexical_pads(const std::shared_ptr<const OpTree> &optree,
+                     const std::vector<std::string> &argument_names,
+                     const PadScopes &enclosing) {
+  PadScopes scopes{optree->pad_layout(argument_names)};
+  scopes.insert(scopes.end(), enclosing.begin(), enclosing.end());
+  return std::make_shared<OpTree>(resolve_lexical_pads(optree->root, scopes));
+}
+
 static std::optional<StateMachineOperation::StateMap> construct_state_map(
     const std::unordered_map<std::string,
                              std::shared_ptr<const sema::ast::State>> &states) {
@@ -495,7 +584,11 @@ static std::optional<StateMachineOperation::StateMap> construct_state_map(
         state_transitions_type = TransitionType::Read;
       switch (state_transitions_type.value()) {
       case TransitionType::Read: {
-        auto maybe_optree = generate_read_state_callback(state_pair.second);
+        // the lookahead picks the transition by ID, which is assigned
+        // the same way when the state machine interns its transitions.
+        auto maybe_optree = generate_read_state_callback(
+            state_pair.second,
+            StateMachineOperation::transition_ids(state_info.transitions));
         if (!maybe_optree)
           return std::nullopt;
         state_info.callback_optree = *maybe_optree;
@@ -511,6 +604,13 @@ static std::optional<StateMachineOperation::StateMap> construct_state_map(
           OpTree(OpTreeNode{UnaryCallback(state_pair.first),
                             {{LexicalPadGet{"dictionary"}, {}}}}));
     }
+    state_info.callback_optree = resolve_lexical_pads(
+        state_info.callback_optree,
+        StateMachineOperation::state_argument_names(), {});
+    for (auto &[transition_name, transition_info] : state_info.transitions) {
+      transition_info.callback_optree = resolve_lexical_pads(
+          transition_info.callback_optree, transition_info.argument_names, {});
+    }
     state_map[state_pair.first] = state_info;
   }
   return state_map.empty()
@@ -2,6 +2,7 @@
 #include <networkprotocoldsl/generate.hpp>
 #include <networkprotocoldsl/interpretedprogram.hpp>
 #include <networkprotocoldsl/lexer/tokenize.hpp>
+#include <networkprotocoldsl/optimize.hpp>
 #include <networkprotocoldsl/parser/parse.hpp>
 #include <networkprotocoldsl/sema/analyze.hpp>
 
@@ -29,7 +30,7 @@ InterpretedProgram::generate_client_from_source(const std::string &source) {
   auto maybe_client = generate::client(maybe_protocol.value());
   if (!maybe_client.has_value())
     return std::nullopt;
-  return InterpretedProgram(maybe_client.value());
+  return InterpretedProgram(optimize(maybe_client.value()));
 }
 
 // New implementation: generate server from source code contents.
@@ -41,7 +42,7 @@ InterpretedProgram::generate_server_from_source(const std::string &source) {
   auto maybe_server = generate::server(maybe_protocol.value());
   if (!maybe_server.has_value())
     return std::nullopt;
-  return InterpretedProgram(maybe_server.value());
+  return InterpretedProgram(optimize(maybe_server.value()));
 }
 
 std::optional<InterpretedProgram>
@@ -3,11 +3,14 @@
 
 #include <networkprotocoldsl/continuation.hpp>
 #include <networkprotocoldsl/lexicalpad.hpp>
+#include <networkprotocoldsl/support/arena.hpp>
 
 #include <cassert>
 #include <memory>
+#include <memory_resource>
 #include <stack>
 #include <variant>
+#include <vector>
 
 namespace networkprotocoldsl {
 
@@ -22,7 +25,16 @@ namespace networkprotocoldsl {
 class Interpreter {
   std::shared_ptr<const OpTree> optree;
   std::shared_ptr<LexicalPad> rootpad;
-  std::stack<Continuation> continuation_stack;
+  // Continuations of invoked callables and their pads are allocated
+  // from the arena. It must outlive the continuation stack, and it is
+  // held by pointer so it stays in place when the interpreter moves.
+  std::unique_ptr<support::Arena> arena;
+  std::stack<Continuation, std::vector<Continuation>> continuation_stack;
+  // Continuations of calls that returned, reset to run the next calls
+  // instead of setting up new ones. The state machine invokes its
+  // callbacks at the same depth over and over.
+  std::vector<Continuation> spare_continuations;
+  int trace_tag = -1;
 
 public:
   /***
@@ -30,7 +42,11 @@ public:
    * to be executed in the context of a given socket.
    */
   Interpreter(std::shared_ptr<const OpTree> o, std::shared_ptr<LexicalPad> p)
-      : optree(o), rootpad(p), continuation_stack({Continuation(o, rootpad)}){};
+      : optree(o), rootpad(p), arena(std::make_unique<support::Arena>()) {
+    // the root continuation lives for as long as the interpreter, so
+    // it does not use the arena.
+    continuation_stack.push(Continuation(o, rootpad));
+  };
 
   ContinuationState step() {
     ContinuationState s = continuation_stack.top().step();
@@ -44,17 +60,36 @@ public:
         std::shared_ptr<LexicalPad> parent_pad =
             callable.inherits_lexical_pad ? continuation_stack.top().get_pad()
                                           : rootpad;
-        std::shared_ptr<LexicalPad> pad =
-            std::make_shared<LexicalPad>(LexicalPad(parent_pad));
+        std::shared_ptr<const LexicalPadLayout> layout =
+            callable.pad_layout
+                ? callable.pad_layout
+                : callable.tree->pad_layout(callable.argument_names);
+        std::shared_ptr<LexicalPad> pad = std::allocate_shared<LexicalPad>(
+            std::pmr::polymorphic_allocator<LexicalPad>(arena.get()),
+            parent_pad, layout, arena.get());
         std::shared_ptr<const std::vector<Value>> arglist =
             continuation_stack.top().get_argument_list();
+        // the layout starts with the arguments, in order.
         for (size_t i = 0; i < callable.argument_names.size(); i++) {
           if (i >= arglist->size()) {
             break;
           }
-          pad->initialize(callable.argument_names.at(i), arglist->at(i));
+          pad->initialize(i, arglist->at(i));
         }
-        continuation_stack.push(Continuation(callable.tree, pad));
+        if (continuation_stack.size() > 1 &&
+            continuation_stack.top().in_tail_position()) {
+          // nothing is left to do in the caller once the callee
+          // returns, so the callee runs in its place.
+          continuation_stack.top().reset(callable.tree, pad);
+        } else if (!spare_continuations.empty()) {
+          continuation_stack.push(std::move(spare_continuations.back()));
+          spare_continuations.pop_back();
+          continuation_stack.top().reset(callable.tree, pad);
+        } else {
+          continuation_stack.push(
+              Continuation(callable.tree, pad, arena.get()));
+        }
+        continuation_stack.top().set_trace_tag(trace_tag);
         return continuation_stack.top().prepare();
       } else {
         return s;
@@ -62,7 +97,10 @@ public:
     } else if (s == ContinuationState::Exited) {
       Value r = std::get<Value>(continuation_stack.top().get_result());
       if (continuation_stack.size() > 1) {
+        spare_continuations.push_back(std::move(continuation_stack.top()));
+        spare_continuations.back().release();
         continuation_stack.pop();
+        continuation_stack.top().set_trace_tag(trace_tag);
         continuation_stack.top().set_callable_return(r);
         return continuation_stack.top().prepare();
       } else {
@@ -73,6 +111,22 @@ public:
     }
   }
 
+  /***
+   * Operations executed by this interpreter are recorded in the
+   * trace buffer under the given tag, whenever that tag is enabled
+   * with trace::enable. This is a no-op unless the build enables
+   * NETWORKPROTOCOLDSL_ENABLE_TRACING.
+   */
+  void set_trace_tag(int tag) {
+    trace_tag = tag;
+    continuation_stack.top().set_trace_tag(tag);
+  }
+
+  /**
+   * The root continuation plus one for each call still running.
+   */
+  std::size_t stack_depth() const { return continuation_stack.size(); }
+
   ContinuationState result_to_state() {
     return continuation_stack.top().result_to_state();
   }
@@ -83,12 +137,20 @@ public:
     return continuation_stack.top().get_callback_key();
   }
 
+  std::size_t get_callback_id() {
+    return continuation_stack.top().get_callback_id();
+  }
+
   void set_callback_called() { continuation_stack.top().set_callback_called(); }
 
-  const std::vector<Value> &get_callback_arguments() {
+  std::vector<Value> get_callback_arguments() {
     return continuation_stack.top().get_callback_arguments();
   }
 
+  std::vector<Value> take_callback_arguments() {
+    return continuation_stack.top().take_callback_arguments();
+  }
+
   void set_callback_return(Value v) {
     continuation_stack.top().set_callback_return(v);
   }
@@ -97,10 +159,19 @@ public:
     return continuation_stack.top().handle_read(in);
   }
 
+  size_t handle_read(const std::shared_ptr<const std::string> &in,
+                     std::size_t offset = 0) {
+    return continuation_stack.top().handle_read(in, offset);
+  }
+
   std::string_view get_write_buffer() {
     return continuation_stack.top().get_write_buffer();
   }
 
+  value::Octets get_write_octets() {
+    return continuation_stack.top().get_write_octets();
+  }
+
   size_t handle_write(size_t s) {
     return continuation_stack.top().handle_write(s);
   }
@@ -1 +1,55 @@
 #include <networkprotocoldsl/interpretercollection.hpp>
+
+namespace networkprotocoldsl {
+
+void InterpreterSignals::schedule(
+    const std::shared_ptr<InterpreterContext> &context) {
+  if (!context->scheduled.exchange(true)) {
+    ready_interpreters[context->shard % ready_queue_count].push_back(context);
+  }
+  wake_up_interpreter.notify();
+}
+
+std::shared_ptr<InterpreterContext>
+InterpreterSignals::next_ready(std::size_t worker, std::size_t workers) {
+  for (std::size_t q = worker; q < ready_queue_count; q += workers) {
+    if (auto context = ready_interpreters[q].pop()) {
+      return *context;
+    }
+  }
+  for (std::size_t q = 0; q < ready_queue_count; q++) {
+    if (q % workers == worker) {
+      continue;
+    }
+    if (auto context = ready_interpreters[q].pop()) {
+      return *context;
+    }
+  }
+  return nullptr;
+}
+
+bool InterpreterSignals::acquire_callback_slot(
+    const std::shared_ptr<InterpreterContext> &context, std::size_t limit) {
+  if (callbacks_in_flight.fetch_add(1) < limit) {
+    return true;
+  }
+  callbacks_in_flight.fetch_sub(1);
+  waiting_for_callback_slot.push_back(context);
+  // a slot may have been released before the context was queued, in
+  // which case nobody else would schedule it.
+  if (callbacks_in_flight.load() < limit) {
+    if (auto waiting = waiting_for_callback_slot.pop()) {
+      schedule(*waiting);
+    }
+  }
+  return false;
+}
+
+void InterpreterSignals::release_callback_slot() {
+  callbacks_in_flight.fetch_sub(1);
+  if (auto waiting = waiting_for_callback_slot.pop()) {
+    schedule(*waiting);
+  }
+}
+
+} // namespace networkprotocoldsl
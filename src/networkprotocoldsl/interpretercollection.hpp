@@ -2,27 +2,86 @@
 #define INCLUDED_NETWORKPROTOCOLDSL_INTERPRETERCOLLECTION_HPP
 
 #include <networkprotocoldsl/interpretercontext.hpp>
+#include <networkprotocoldsl/support/mutexlockqueue.hpp>
 #include <networkprotocoldsl/support/notificationsignal.hpp>
+#include <networkprotocoldsl/support/persistentmap.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <memory>
-#include <unordered_map>
 
 namespace networkprotocoldsl {
 
 struct InterpreterSignals {
+  // Each signal is for one kind of thread, and only what that thread
+  // has to act on notifies it: the interpreter workers, the thread
+  // taking the output (which also closes the connections of the
+  // interpreters that exited) and the callback loop. Input reaches the
+  // interpreters through schedule(), so nothing in the library waits
+  // on wake_up_for_input.
   support::NotificationSignal wake_up_interpreter;
   support::NotificationSignal wake_up_for_output;
   support::NotificationSignal wake_up_for_input;
   support::NotificationSignal wake_up_for_callback;
+
+  /**
+   * The interpreter workers only look at the contexts that were
+   * scheduled, so whatever hands something to an interpreter (input,
+   * eof, a callback response) has to schedule its context afterwards.
+   * The contexts are queued by shard, so each worker starts with its
+   * own queues before taking from the others.
+   */
+  static constexpr std::size_t ready_queue_count = 16;
+  std::array<support::MutexLockQueue<std::shared_ptr<InterpreterContext>>,
+             ready_queue_count>
+      ready_interpreters;
+  // The contexts that pushed a callback request, for the callback loop.
+  support::MutexLockQueue<std::shared_ptr<InterpreterContext>>
+      pending_callbacks;
+  // How many callbacks are pending or running, and the contexts that
+  // wait for one of them to finish before they can start theirs.
+  std::atomic<std::size_t> callbacks_in_flight = 0;
+  support::MutexLockQueue<std::shared_ptr<InterpreterContext>>
+      waiting_for_callback_slot;
+
   InterpreterSignals()
       : wake_up_interpreter(support::NotificationSignal("interpreter")),
         wake_up_for_output(support::NotificationSignal("output")),
         wake_up_for_input(support::NotificationSignal("input")),
         wake_up_for_callback(support::NotificationSignal("callback")) {}
+
+  /**
+   * Queues the context for the interpreter workers, unless it is
+   * queued already, and wakes them up.
+   */
+  void schedule(const std::shared_ptr<InterpreterContext> &context);
+
+  /**
+   * Takes the next scheduled context, looking at the queues of the
+   * given worker first.
+   */
+  std::shared_ptr<InterpreterContext> next_ready(std::size_t worker,
+                                                 std::size_t workers);
+
+  /**
+   * Takes one of the limit slots for a callback of the context, or
+   * else queues the context to be scheduled again once a slot is
+   * released.
+   */
+  bool acquire_callback_slot(const std::shared_ptr<InterpreterContext> &context,
+                             std::size_t limit);
+
+  /**
+   * Gives back the slot of a callback that finished.
+   */
+  void release_callback_slot();
 };
 
 struct InterpreterCollection {
-  const std::unordered_map<int, std::shared_ptr<InterpreterContext>>
+  // Each version of the collection shares most of its map with the
+  // previous one, so adding or removing a connection is cheap.
+  const support::PersistentMap<int, std::shared_ptr<InterpreterContext>>
       interpreters;
   const std::shared_ptr<InterpreterSignals> signals =
       std::make_shared<InterpreterSignals>();
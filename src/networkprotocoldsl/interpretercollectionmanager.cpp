@@ -3,6 +3,7 @@
 #include <networkprotocoldsl/interpretercontext.hpp>
 #include <networkprotocoldsl/support/notificationsignal.hpp>
 
+#include <functional>
 #include <memory>
 
 namespace networkprotocoldsl {
@@ -18,27 +19,22 @@ std::future<Value> InterpreterCollectionManager::insert_interpreter(
   std::shared_ptr<InterpreterContext> ctx =
       std::make_shared<InterpreterContext>(program.get_instance(arglist));
   ctx->additional_data = additional_data;
+  ctx->interpreter.set_trace_tag(fd);
+  ctx->shard = std::hash<int>{}(fd);
   _collection.do_transaction(
       [&fd, &ctx](std::shared_ptr<const InterpreterCollection> current)
           -> std::shared_ptr<const InterpreterCollection> {
-        auto new_interpreters = current->interpreters;
-        auto old_interpreter_it = new_interpreters.find(fd);
-        if (old_interpreter_it != new_interpreters.end()) {
-          if (old_interpreter_it->second->exited.load()) {
-            new_interpreters.erase(fd);
-          } else {
-            throw std::runtime_error("Interpreter already exists for fd");
-          }
+        auto old_interpreter_it = current->interpreters.find(fd);
+        if (old_interpreter_it != current->interpreters.end() &&
+            !old_interpreter_it->second->exited.load()) {
+          throw std::runtime_error("Interpreter already exists for fd");
         }
-        new_interpreters.insert({fd, ctx});
         return std::make_shared<InterpreterCollection>(
-            std::move(new_interpreters), current->signals);
+            current->interpreters.with(fd, ctx), current->signals);
       });
-  auto signals = _collection.current()->signals;
-  signals->wake_up_interpreter.notify();
-  signals->wake_up_for_output.notify();
-  signals->wake_up_for_input.notify();
-  signals->wake_up_for_callback.notify();
+  // the output and callback sides find out about it when it has
+  // something for them.
+  _collection.current()->signals->schedule(ctx);
 
   return ctx->interpreter_result.get_future();
 }
@@ -47,15 +43,13 @@ void InterpreterCollectionManager::remove_interpreter(int fd) {
   _collection.do_transaction(
       [fd](std::shared_ptr<const InterpreterCollection> current)
           -> const std::shared_ptr<const InterpreterCollection> {
-        auto new_interpreters = current->interpreters;
-        new_interpreters.erase(fd);
         return std::make_shared<const InterpreterCollection>(
-            std::move(new_interpreters), current->signals);
+            current->interpreters.without(fd), current->signals);
       });
+  // the loops that stop once every interpreter is gone look again.
   auto signals = _collection.current()->signals;
   signals->wake_up_interpreter.notify();
   signals->wake_up_for_output.notify();
-  signals->wake_up_for_input.notify();
   signals->wake_up_for_callback.notify();
 }
 } // namespace networkprotocoldsl
\ No newline at end of file
@@ -3,15 +3,28 @@
 
 #include <networkprotocoldsl/interpreter.hpp>
 #include <networkprotocoldsl/operationconcepts.hpp>
-#include <networkprotocoldsl/support/mutexlockqueue.hpp>
+#include <networkprotocoldsl/support/receivebuffer.hpp>
+#include <networkprotocoldsl/support/spscqueue.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <future>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace networkprotocoldsl {
 
+/**
+ * A callback an interpreter asks the callback loop to run, with the
+ * key already resolved to its id in the CallbackRegistry.
+ */
+struct CallbackRequest {
+  std::size_t callback_id;
+  std::vector<Value> arguments;
+};
+
 class InterpreterResultIsNotValue : std::exception {
 public:
   OperationResult result;
@@ -20,18 +33,40 @@ public:
 
 struct InterpreterContext {
   Interpreter interpreter;
-  support::MutexLockQueue<std::string> input_buffer;
-  support::MutexLockQueue<std::string> output_buffer;
-  support::MutexLockQueue<std::pair<std::string, const std::vector<Value>>>
-      callback_request_queue;
-  support::MutexLockQueue<Value> callback_response_queue;
+  // Each queue has one producer and one consumer: the I/O side and
+  // the thread stepping the interpreter, or the latter and the
+  // callback loop.
+  support::SpscQueue<std::string> input_buffer{256};
+  // What the writes produced, sharing storage with the values and
+  // operations written, for the I/O side to send together.
+  support::SpscQueue<value::Octets> output_buffer{64};
+  support::SpscQueue<CallbackRequest> callback_request_queue{4};
+  support::SpscQueue<Value> callback_response_queue{4};
+  // What arrived on input_buffer and was not consumed yet, only
+  // touched by the thread stepping the interpreter.
+  support::ReceiveBuffer receive_buffer;
   std::promise<Value> interpreter_result;
   void *additional_data;
 
   std::atomic<bool> eof = false;
+  // Set by the I/O side when input_buffer was full and it stopped
+  // reading from the connection instead of waiting for room, until it
+  // reads from it again.
+  std::atomic<bool> input_paused = false;
   std::atomic<bool> exited = false;
 
-  InterpreterContext(const Interpreter &interp) : interpreter(interp) {}
+  // Which ready queue the context goes to, and through it which
+  // interpreter worker looks at it first.
+  std::size_t shard = 0;
+  // Held by the thread currently stepping the interpreter.
+  std::atomic<bool> stepping = false;
+  // Whether the writes of the current quantum queued anything the I/O
+  // side wasn't told about yet, only touched by the thread stepping
+  // the interpreter.
+  bool output_pending = false;
+  // Whether the context is waiting in a ready queue.
+  std::atomic<bool> scheduled = false;
+
   InterpreterContext(Interpreter &&interp) : interpreter(std::move(interp)) {}
 
   InterpreterContext() = delete;
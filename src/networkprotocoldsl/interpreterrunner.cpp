@@ -1,4 +1,5 @@
 #include "networkprotocoldsl/value.hpp"
+#include <networkprotocoldsl/callbackregistry.hpp>
 #include <networkprotocoldsl/continuation.hpp>
 #include <networkprotocoldsl/interpretercollection.hpp>
 #include <networkprotocoldsl/interpretercollectionmanager.hpp>
@@ -6,10 +7,13 @@
 #include <networkprotocoldsl/interpreterrunner.hpp>
 #include <networkprotocoldsl/operationconcepts.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <thread>
 #include <variant>
+#include <vector>
 
 #define INTERPRETERRUNNER_DEBUG(x)
 //#define INTERPRETERRUNNER_DEBUG(x) std::cerr << "InterpreterRunner[" << \
@@ -22,104 +26,90 @@ namespace {
 // Result of handling a blocked interpreter
 enum class HandleBlockedResult {
   StillBlocked,  // Interpreter is still blocked, needs external event
-  Unblocked,     // Interpreter is now ready to proceed
-  NeedsRetry     // Interpreter should be retried (e.g., after buffer concatenation)
+  Unblocked      // Interpreter is now ready to proceed
 };
 
 static HandleBlockedResult handle_read(InterpreterContext &context,
                                        InterpreterSignals &signals) {
-  auto buffer = context.input_buffer.pop();
-  if (buffer.has_value()) {
-    INTERPRETERRUNNER_DEBUG("handle_read: got buffer of size " << buffer->size() << ": '"
-                                      << *buffer << "'");
-    size_t consumed = context.interpreter.handle_read(buffer.value());
+  // One network notification may result in multiple buffer fragments,
+  // so everything that arrived goes after what is left from before,
+  // and the operation gets to see all of it at once.
+  while (auto chunk = context.input_buffer.pop()) {
+    INTERPRETERRUNNER_DEBUG("handle_read: got buffer of size " << chunk->size() << ": '"
+                                      << *chunk << "'");
+    context.receive_buffer.append(*chunk);
+  }
+  if (context.input_paused.load()) {
+    // the output side gets the I/O side to read again now that there
+    // is room.
+    signals.wake_up_for_output.notify();
+  }
+  if (!context.receive_buffer.empty()) {
+    // The buffer is handed over reference counted, so what is read
+    // from it can be kept as a slice instead of being copied out.
+    size_t consumed = context.interpreter.handle_read(
+        context.receive_buffer.buffer(), context.receive_buffer.offset());
     INTERPRETERRUNNER_DEBUG("handle_read: consumed " << consumed << " bytes");
-    if (consumed == 0) {
-      // Since the op didn't consume anything, keep joining with subsequent
-      // buffers until either parsing succeeds or there are no more buffers.
-      // This is necessary because one network notification may result in
-      // multiple buffer fragments, and we need to join them all before
-      // declaring that we need more data.
-      std::string joined = buffer.value();
-      bool did_join = false;
-      while (consumed == 0) {
-        auto nextbuffer = context.input_buffer.pop();
-        if (nextbuffer.has_value()) {
-          did_join = true;
-          INTERPRETERRUNNER_DEBUG("handle_read: joining buffers, adding " << nextbuffer->size() << " bytes: '"
-                                            << *nextbuffer << "'");
-          joined += nextbuffer.value();
-          consumed = context.interpreter.handle_read(joined);
-          INTERPRETERRUNNER_DEBUG("handle_read: after joined read, consumed " << consumed << " bytes");
-        } else {
-          // No more buffers available, push back what we have
-          context.input_buffer.push_front(joined);
-          INTERPRETERRUNNER_DEBUG("handle_read: pushed back joined buffer of size " << joined.size() << ": '"
-                                            << joined << "'");
-          // Check if the operation is ready to evaluate even though it consumed 0 bytes.
-          // This handles lookahead operations that store data without consuming.
-          if (context.interpreter.ready_to_evaluate()) {
-            INTERPRETERRUNNER_DEBUG("handle_read: operation is ready to evaluate despite consumed=0");
-            return HandleBlockedResult::Unblocked;
-          }
-          // If we joined buffers, request a retry - the operation may now
-          // have enough data to proceed (e.g., lookahead operations that
-          // store data without consuming). If we didn't join anything,
-          // we're truly blocked waiting for more data.
-          return did_join ? HandleBlockedResult::NeedsRetry 
-                          : HandleBlockedResult::StillBlocked;
-        }
-      }
-      // We consumed something from the joined buffer
-      if (consumed < joined.size()) {
-        context.input_buffer.push_front(joined.substr(consumed));
-        INTERPRETERRUNNER_DEBUG("handle_read: pushed back unconsumed data of size " << (joined.size() - consumed) << ": '"
-                                          << joined.substr(consumed) << "'");
-      }
+    if (consumed > 0) {
+      context.receive_buffer.consume(consumed);
       return HandleBlockedResult::Unblocked;
-    } else {
-      if (consumed < buffer.value().size()) {
-        INTERPRETERRUNNER_DEBUG("handle_read: pushed back unconsumed data of size " << (buffer->size() - consumed) << ": '"
-                                          << buffer->substr(consumed) << "'");
-        context.input_buffer.push_front(buffer->substr(consumed));
-      }
+    }
+    // Check if the operation is ready to evaluate even though it consumed 0 bytes.
+    // This handles lookahead operations that store data without consuming.
+    if (context.interpreter.ready_to_evaluate()) {
+      INTERPRETERRUNNER_DEBUG("handle_read: operation is ready to evaluate despite consumed=0");
       return HandleBlockedResult::Unblocked;
     }
+    // the operation already saw everything that arrived, so it waits
+    // for more data.
+    return HandleBlockedResult::StillBlocked;
   } else {
     if (context.eof.load()) {
       context.interpreter.handle_eof();
       INTERPRETERRUNNER_DEBUG("handle_read: EOF reached");
       return HandleBlockedResult::Unblocked;
     }
-    signals.wake_up_for_input.notify();
-    signals.wake_up_for_output.notify();
   }
+  // whoever hands it more input schedules it again.
   return HandleBlockedResult::StillBlocked;
 }
 
 HandleBlockedResult handle_write(InterpreterContext &context, InterpreterSignals &signals) {
   if (context.eof.load()) {
     context.interpreter.handle_eof();
-    signals.wake_up_for_output.notify();
-    signals.wake_up_for_input.notify();
     return HandleBlockedResult::Unblocked;
   } else {
-    auto buffer = context.interpreter.get_write_buffer();
-    std::string copy(buffer);
-    context.output_buffer.push_back(copy);
-    context.interpreter.handle_write(buffer.size());
-    signals.wake_up_for_output.notify();
+    auto octets = context.interpreter.get_write_octets();
+    std::size_t size = octets.data.view().size();
+    if (!context.output_buffer.try_push(std::move(octets))) {
+      // the I/O side has to make room before the end of the quantum.
+      signals.wake_up_for_output.notify();
+      context.output_buffer.push_back(std::move(octets));
+    }
+    context.interpreter.handle_write(size);
+    // the I/O side is told at the end of the quantum, so that it sends
+    // everything written until then together.
+    context.output_pending = true;
     return HandleBlockedResult::Unblocked;
   }
 }
 
-HandleBlockedResult handle_start_callback(InterpreterContext &context,
-                           InterpreterSignals &signals) {
-  context.callback_request_queue.push_back(
-      std::make_pair(context.interpreter.get_callback_key(),
-                     context.interpreter.get_callback_arguments()));
-  context.interpreter.set_callback_called();
-  signals.wake_up_for_callback.notify();
+HandleBlockedResult
+handle_start_callback(const std::shared_ptr<InterpreterContext> &context,
+                      InterpreterSignals &signals,
+                      const InterpreterRunner &runner) {
+  if (!signals.acquire_callback_slot(context, runner.max_pending_callbacks)) {
+    // scheduled again once a callback finishes.
+    return HandleBlockedResult::StillBlocked;
+  }
+  // the operation is done with its arguments, so they are moved along
+  // instead of copied.
+  context->callback_request_queue.push_back(
+      CallbackRequest{context->interpreter.get_callback_id(),
+                      context->interpreter.take_callback_arguments()});
+  context->interpreter.set_callback_called();
+  signals.pending_callbacks.push_back(context);
+  signals.wake_up_for_callback.notify_one();
   return HandleBlockedResult::Unblocked;
 }
 
@@ -134,25 +124,27 @@ HandleBlockedResult handle_finish_callback(InterpreterContext &context,
   }
 }
 
-HandleBlockedResult handle_blocked_interpreter(InterpreterContext &context,
-                                InterpreterSignals &signals) {
+HandleBlockedResult
+handle_blocked_interpreter(const std::shared_ptr<InterpreterContext> &context,
+                           InterpreterSignals &signals,
+                           const InterpreterRunner &runner) {
   using namespace networkprotocoldsl;
-  OperationResult r = context.interpreter.get_result();
+  OperationResult r = context->interpreter.get_result();
   if (std::holds_alternative<ReasonForBlockedOperation>(r)) {
     ReasonForBlockedOperation reason = std::get<ReasonForBlockedOperation>(r);
     switch (reason) {
     case ReasonForBlockedOperation::WaitingForRead:
       INTERPRETERRUNNER_DEBUG("WaitingForRead");
-      return handle_read(context, signals);
+      return handle_read(*context, signals);
     case ReasonForBlockedOperation::WaitingForWrite:
       INTERPRETERRUNNER_DEBUG("WaitingForWrite");
-      return handle_write(context, signals);
+      return handle_write(*context, signals);
     case ReasonForBlockedOperation::WaitingForCallback:
       INTERPRETERRUNNER_DEBUG("WaitingForCallback");
-      return handle_start_callback(context, signals);
+      return handle_start_callback(context, signals, runner);
     case ReasonForBlockedOperation::WaitingCallbackData:
       INTERPRETERRUNNER_DEBUG("WaitingCallbackData");
-      return handle_finish_callback(context, signals);
+      return handle_finish_callback(*context, signals);
     case ReasonForBlockedOperation::WaitingForCallableInvocation:
     case ReasonForBlockedOperation::WaitingForCallableResult:
       INTERPRETERRUNNER_DEBUG("WaitingForCallableInvocation/Result");
@@ -162,135 +154,296 @@ HandleBlockedResult handle_blocked_interpreter(InterpreterContext &context,
   }
   return HandleBlockedResult::Unblocked;
 }
+
+// Result of stepping an interpreter
+enum class StepOutcome {
+  Inactive, // The interpreter has exited
+  Busy,     // Another worker is stepping it
+  Ready,    // The interpreter can proceed
+  Blocked   // The interpreter waits for an external event
+};
+
+// Steps an interpreter once, the caller holds its stepping flag.
+static StepOutcome
+step_once(const std::shared_ptr<InterpreterContext> &context,
+          const InterpreterCollection &collection,
+          const InterpreterRunner &runner) {
+  StepOutcome outcome = StepOutcome::Ready;
+  auto state = context->interpreter.step();
+  switch (state) {
+  case ContinuationState::MissingArguments:
+  case ContinuationState::Ready:
+    INTERPRETERRUNNER_DEBUG("Ready interpreter");
+    break;
+  case ContinuationState::Blocked: {
+    auto result =
+        handle_blocked_interpreter(context, *collection.signals, runner);
+    switch (result) {
+    case HandleBlockedResult::Unblocked:
+      break;
+    case HandleBlockedResult::StillBlocked:
+      outcome = StepOutcome::Blocked;
+      break;
+    }
+    INTERPRETERRUNNER_DEBUG("Blocked interpreter");
+    break;
+  }
+  case ContinuationState::Exited:
+    context->exited.store(true);
+    OperationResult r = context->interpreter.get_result();
+    if (std::holds_alternative<Value>(r)) {
+      Value v = std::get<Value>(r);
+
+      context->interpreter_result.set_value(v);
+    } else {
+      context->interpreter_result.set_exception(
+          std::make_exception_ptr(InterpreterResultIsNotValue(r)));
+    }
+    // the output side closes the connection.
+    collection.signals->wake_up_for_output.notify();
+    INTERPRETERRUNNER_DEBUG("Exited interpreter");
+    outcome = StepOutcome::Inactive;
+    break;
+  };
+  return outcome;
+}
+
+// Steps an interpreter until it blocks, exits or has taken as many
+// steps as the runner's quantum, whichever comes first.
+static StepOutcome
+step_context(const std::shared_ptr<InterpreterContext> &context,
+             const InterpreterCollection &collection,
+             const InterpreterRunner &runner) {
+  if (context->exited.load()) {
+    return StepOutcome::Inactive;
+  }
+  bool expected = false;
+  if (!context->stepping.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acquire)) {
+    return StepOutcome::Busy;
+  }
+  // it may have exited while the other worker had it.
+  if (context->exited.load()) {
+    context->stepping.store(false, std::memory_order_release);
+    return StepOutcome::Inactive;
+  }
+  StepOutcome outcome = StepOutcome::Ready;
+  std::size_t quantum = std::max<std::size_t>(runner.steps_per_quantum, 1);
+  for (std::size_t steps = 0; steps < quantum; steps++) {
+    outcome = step_once(context, collection, runner);
+    if (outcome != StepOutcome::Ready) {
+      break;
+    }
+  }
+  if (context->output_pending) {
+    context->output_pending = false;
+    collection.signals->wake_up_for_output.notify();
+  }
+  context->stepping.store(false, std::memory_order_release);
+  return outcome;
+}
+
+static bool all_exited(const InterpreterCollection &collection) {
+  for (const auto &[fd, context] : collection.interpreters) {
+    if (!context->exited.load()) {
+      return false;
+    }
+  }
+  return true;
+}
 } // namespace
 
 void InterpreterRunner::interpreter_loop(InterpreterCollectionManager &mgr) {
+  interpreter_loop(mgr, 0, 1);
+}
+
+void InterpreterRunner::interpreter_loop(InterpreterCollectionManager &mgr,
+                                         std::size_t worker,
+                                         std::size_t workers) {
+  // how many contexts to take from the queues before looking at the
+  // collection and the exit flag again.
+  constexpr int batch = 64;
   while (true) {
     auto collection = mgr.get_collection();
-    int active_interpreters = 0;
-    int ready_interpreters = 0;
-    bool needs_retry = false;
-    for (auto &[fd, context] : collection->interpreters) {
-      if (context->exited.load()) {
-        continue;
+    auto &signals = *collection->signals;
+    // taken before looking at the queues, so any context scheduled
+    // while doing so keeps this worker from going to sleep.
+    auto generation = signals.wake_up_interpreter.current_generation();
+    int stepped = 0;
+    while (stepped < batch) {
+      auto context = signals.next_ready(worker, workers);
+      if (!context) {
+        break;
       }
-      auto state = context->interpreter.step();
-      switch (state) {
-      case ContinuationState::MissingArguments:
-      case ContinuationState::Ready:
-        ready_interpreters++;
-        active_interpreters++;
-        INTERPRETERRUNNER_DEBUG("Ready interpreter");
+      stepped++;
+      // cleared before stepping, so anything arriving during the step
+      // schedules the context again.
+      context->scheduled.store(false);
+      switch (step_context(context, *collection, *this)) {
+      case StepOutcome::Busy:
+        // another worker is stepping it, give it a chance to finish.
+        std::this_thread::yield();
+        signals.schedule(context);
         break;
-      case ContinuationState::Blocked: {
-        active_interpreters++;
-        auto result = handle_blocked_interpreter(*context, *collection->signals);
-        switch (result) {
-        case HandleBlockedResult::Unblocked:
-          ready_interpreters++;
-          break;
-        case HandleBlockedResult::NeedsRetry:
-          needs_retry = true;
-          break;
-        case HandleBlockedResult::StillBlocked:
-          break;
-        }
-        INTERPRETERRUNNER_DEBUG("Blocked interpreter");
+      case StepOutcome::Ready:
+        // it used up its quantum, let the others have a turn.
+        signals.schedule(context);
         break;
-      }
-      case ContinuationState::Exited:
-        context->exited.store(true);
-        OperationResult r = context->interpreter.get_result();
-        if (std::holds_alternative<Value>(r)) {
-          Value v = std::get<Value>(r);
-
-          context->interpreter_result.set_value(v);
-        } else {
-          context->interpreter_result.set_exception(
-              std::make_exception_ptr(InterpreterResultIsNotValue(r)));
+      case StepOutcome::Inactive:
+        if (exit_when_done.load()) {
+          // the callback loop may be waiting for the last one to exit.
+          signals.wake_up_for_callback.notify();
         }
-        collection->signals->wake_up_for_output.notify();
-        collection->signals->wake_up_for_input.notify();
-        collection->signals->wake_up_for_callback.notify();
-        collection->signals->wake_up_interpreter.notify();
-        INTERPRETERRUNNER_DEBUG("Exited interpreter");
         break;
-      };
+      case StepOutcome::Blocked:
+        // whatever unblocks it will schedule it again.
+        break;
+      }
+    }
+    if (stepped > 0) {
+      continue;
     }
     bool loaded_exit_when_done = exit_when_done.load();
     if (mgr.get_collection() == collection) {
-      if (active_interpreters == 0) {
-        if (loaded_exit_when_done) {
-          collection->signals->wake_up_for_callback.notify();
-          collection->signals->wake_up_for_input.notify();
-          collection->signals->wake_up_for_output.notify();
-          break;
-        } else {
-          INTERPRETERRUNNER_DEBUG("Waiting, no active interpreter");
-          collection->signals->wake_up_interpreter.wait();
-          INTERPRETERRUNNER_DEBUG("Woken up...");
-        }
+      if (loaded_exit_when_done && all_exited(*collection)) {
+        // the other workers leave as well.
+        signals.wake_up_interpreter.notify();
+        signals.wake_up_for_callback.notify();
+        signals.wake_up_for_output.notify();
+        break;
       } else {
-        // Only wait if no interpreter is ready AND no interpreter needs retry.
-        // NeedsRetry means we concatenated buffers and should re-step to see
-        // if the operation can now proceed (e.g., lookahead operations).
-        if (ready_interpreters == 0 && !needs_retry) {
-          INTERPRETERRUNNER_DEBUG("Waiting, no ready interpreter");
-          collection->signals->wake_up_interpreter.wait();
-          INTERPRETERRUNNER_DEBUG("Woken up...");
-        }
+        INTERPRETERRUNNER_DEBUG("Waiting, no ready interpreter");
+        signals.wake_up_interpreter.wait_for_generation_change(generation);
+        INTERPRETERRUNNER_DEBUG("Woken up...");
       }
     }
   }
 }
 
-void InterpreterRunner::callback_loop(InterpreterCollectionManager &mgr) {
+struct CallbackCompletion::State {
+  std::shared_ptr<InterpreterContext> context;
+  std::shared_ptr<InterpreterSignals> signals;
+  std::atomic<bool> completed = false;
+
+  State(std::shared_ptr<InterpreterContext> c,
+        std::shared_ptr<InterpreterSignals> s)
+      : context(std::move(c)), signals(std::move(s)) {}
+
+  void complete(Value result) {
+    if (completed.exchange(true)) {
+      return;
+    }
+    context->callback_response_queue.push_back(std::move(result));
+    signals->schedule(context);
+    signals->release_callback_slot();
+  }
+
+  ~State() { complete(value::RuntimeError::TypeError); }
+};
+
+CallbackCompletion::CallbackCompletion(
+    std::shared_ptr<InterpreterContext> context,
+    std::shared_ptr<InterpreterSignals> signals)
+    : state(std::make_shared<State>(std::move(context), std::move(signals))) {
+}
+
+void CallbackCompletion::operator()(Value result) const {
+  state->complete(std::move(result));
+}
+
+namespace {
+
+// The functions of the runner, indexed by the id of their key.
+struct BoundCallback {
+  InterpreterRunner::callback_function function;
+  InterpreterRunner::async_callback_function async_function;
+};
+
+static std::vector<BoundCallback>
+bind_callbacks(const InterpreterRunner &runner) {
+  std::vector<BoundCallback> bound;
+  auto slot = [&bound](const std::string &key) -> BoundCallback & {
+    std::size_t id = CallbackRegistry::resolve(key);
+    if (id >= bound.size()) {
+      bound.resize(id + 1);
+    }
+    return bound[id];
+  };
+  for (const auto &[key, function] : runner.callbacks) {
+    slot(key).function = function;
+  }
+  for (const auto &[key, function] : runner.async_callbacks) {
+    slot(key).async_function = function;
+  }
+  return bound;
+}
+
+// One of the threads of the callback pool.
+static void run_callbacks(InterpreterRunner &runner,
+                          InterpreterCollectionManager &mgr,
+                          const std::vector<BoundCallback> &bound) {
   while (true) {
     int callbacks_count = 0;
-    int active_interpreters = 0;
     auto collection = mgr.get_collection();
-    for (auto &[fd, context] : collection->interpreters) {
-      if (context->exited.load()) {
+    auto &signals = *collection->signals;
+    // taken before looking at the queue, see wake_up_interpreter.
+    auto generation = signals.wake_up_for_callback.current_generation();
+    while (auto context = signals.pending_callbacks.pop()) {
+      auto request = (*context)->callback_request_queue.pop();
+      if (!request.has_value()) {
         continue;
       }
-      active_interpreters++;
-      auto cbdata = context->callback_request_queue.pop();
-      if (cbdata.has_value()) {
-        callbacks_count++;
-        const auto &key = cbdata.value().first;
-        const auto cb_it = callbacks.find(key);
-        if (cb_it == callbacks.end()) {
-          context->callback_response_queue.push_back(
-              value::RuntimeError::TypeError);
-        } else {
-          auto fp = cb_it->second;
-          context->callback_response_queue.push_back(fp(cbdata.value().second));
-        }
-        collection->signals->wake_up_interpreter.notify();
+      callbacks_count++;
+      std::size_t id = request->callback_id;
+      const BoundCallback *callback = id < bound.size() ? &bound[id] : nullptr;
+      if (callback && callback->async_function) {
+        // the completion pushes the response and schedules the
+        // context, whenever and wherever the work finishes.
+        callback->async_function(
+            request->arguments,
+            CallbackCompletion(*context, collection->signals));
+        continue;
+      }
+      if (callback && callback->function) {
+        (*context)->callback_response_queue.push_back(
+            callback->function(request->arguments));
+      } else {
+        (*context)->callback_response_queue.push_back(
+            value::RuntimeError::TypeError);
       }
+      signals.schedule(*context);
+      signals.release_callback_slot();
     }
-    bool loaded_exit_when_done = exit_when_done.load();
-    if (mgr.get_collection() == collection) {
-      if (active_interpreters == 0) {
-        if (loaded_exit_when_done) {
-          collection->signals->wake_up_interpreter.notify();
-          collection->signals->wake_up_for_input.notify();
-          collection->signals->wake_up_for_output.notify();
-          break;
-        } else {
-          INTERPRETERRUNNER_DEBUG("Waiting, no active interpreter");
-          collection->signals->wake_up_for_callback.wait();
-          INTERPRETERRUNNER_DEBUG("Woken up...");
-        }
+    bool loaded_exit_when_done = runner.exit_when_done.load();
+    if (mgr.get_collection() == collection && callbacks_count == 0) {
+      if (loaded_exit_when_done && all_exited(*collection)) {
+        // the other threads of the pool leave as well.
+        signals.wake_up_for_callback.notify();
+        signals.wake_up_interpreter.notify();
+        signals.wake_up_for_output.notify();
+        break;
       } else {
-        if (callbacks_count == 0) {
-          INTERPRETERRUNNER_DEBUG("Waiting, no callbacks to process");
-          collection->signals->wake_up_for_callback.wait();
-          INTERPRETERRUNNER_DEBUG("Woken up...");
-        }
+        INTERPRETERRUNNER_DEBUG("Waiting, no callbacks to process");
+        signals.wake_up_for_callback.wait_for_generation_change(generation);
+        INTERPRETERRUNNER_DEBUG("Woken up...");
       }
     }
   }
 }
 
+} // namespace
+
+void InterpreterRunner::callback_loop(InterpreterCollectionManager &mgr) {
+  const std::vector<BoundCallback> bound = bind_callbacks(*this);
+  std::vector<std::thread> pool;
+  for (std::size_t t = 1; t < callback_threads; t++) {
+    pool.emplace_back(
+        [this, &mgr, &bound] { run_callbacks(*this, mgr, bound); });
+  }
+  run_callbacks(*this, mgr, bound);
+  for (auto &thread : pool) {
+    thread.join();
+  }
+}
+
 } // namespace networkprotocoldsl
\ No newline at end of file
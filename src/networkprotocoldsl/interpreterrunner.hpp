@@ -4,16 +4,89 @@
 #include <networkprotocoldsl/interpretercollectionmanager.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <cstddef>
 #include <future>
+#include <memory>
 
 namespace networkprotocoldsl {
 
+struct InterpreterContext;
+struct InterpreterSignals;
+
+/**
+ * Hands the result of an asynchronous callback back to the interpreter
+ * that asked for it, from whatever thread the work finished on.
+ *
+ * Copies share the same completion, and only the first call counts. If
+ * every copy is dropped without being called, the interpreter gets a
+ * TypeError, the same as for a callback that doesn't exist, instead of
+ * waiting forever.
+ */
+class CallbackCompletion {
+  struct State;
+  std::shared_ptr<State> state;
+
+public:
+  CallbackCompletion(std::shared_ptr<InterpreterContext> context,
+                     std::shared_ptr<InterpreterSignals> signals);
+  void operator()(Value result) const;
+};
+
 struct InterpreterRunner {
   using callback_function = std::function<Value(const std::vector<Value> &)>;
   using callback_map = std::unordered_map<std::string, callback_function>;
   callback_map callbacks;
   std::atomic<bool> exit_when_done = false;
+  /**
+   * Callbacks that start some work and return right away, calling the
+   * completion once the work is done. The callback threads don't wait
+   * for them, so a few threads can have any number of them in flight,
+   * up to max_pending_callbacks.
+   */
+  using async_callback_function =
+      std::function<void(const std::vector<Value> &, CallbackCompletion)>;
+  using async_callback_map =
+      std::unordered_map<std::string, async_callback_function>;
+  async_callback_map async_callbacks;
+  /**
+   * How many steps an interpreter is run for each time a worker picks
+   * it up, unless it blocks or exits before that. A larger quantum
+   * spends less time going through the ready queues, a smaller one
+   * gets the other interpreters their turn sooner.
+   */
+  std::size_t steps_per_quantum = 256;
+  /**
+   * How many threads callback_loop runs the callbacks on. An
+   * interpreter only asks for its next callback once it got the
+   * response of the previous one, so the callbacks of each connection
+   * still run one after the other, in order, while those of different
+   * connections run at the same time.
+   */
+  std::size_t callback_threads = 1;
+  /**
+   * How many callbacks may be waiting for or running on the callback
+   * threads at once. Interpreters that want to start one beyond that
+   * wait until one finishes, instead of piling up requests the pool
+   * can't keep up with.
+   */
+  std::size_t max_pending_callbacks = 1024;
   void interpreter_loop(InterpreterCollectionManager &mgr);
+  /**
+   * Runs one of several interpreter workers over the same collection.
+   * Each worker steps the interpreters whose shard falls on it, and
+   * when none of those has anything to do it steps the ones of other
+   * workers that are ready to make progress. An interpreter is only
+   * ever stepped by one thread at a time.
+   */
+  void interpreter_loop(InterpreterCollectionManager &mgr, std::size_t worker,
+                        std::size_t workers);
+  /**
+   * Runs the callbacks the interpreters ask for, on callback_threads
+   * threads including the calling one, until every interpreter exited
+   * and exit_when_done is set. The functions in callbacks and
+   * async_callbacks are bound to the ids of their keys once, when it
+   * starts, so changing the maps afterwards has no effect.
+   */
   void callback_loop(InterpreterCollectionManager &mgr);
 };
 
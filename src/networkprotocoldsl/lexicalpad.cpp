@@ -2,49 +2,133 @@
 
 namespace networkprotocoldsl {
 
+std::string stringify_slot(const std::optional<LexicalPadSlot> &slot) {
+  if (!slot.has_value()) {
+    return "";
+  }
+  return ", depth: " + std::to_string(slot->depth) +
+         ", slot: " + std::to_string(slot->slot);
+}
+
+std::optional<std::size_t>
+LexicalPad::find_slot(const std::string &name) const {
+  std::size_t declared = layout ? layout->size() : 0;
+  for (std::size_t i = 0; i < declared; i++) {
+    if ((*layout)[i] == name) {
+      return i;
+    }
+  }
+  for (std::size_t i = 0; i < extra_names.size(); i++) {
+    if (extra_names[i] == name) {
+      return declared + i;
+    }
+  }
+  return std::nullopt;
+}
+
+const std::string &LexicalPad::slot_name(std::size_t slot) const {
+  std::size_t declared = layout ? layout->size() : 0;
+  if (slot < declared) {
+    return (*layout)[slot];
+  } else {
+    return extra_names[slot - declared];
+  }
+}
+
+LexicalPad *LexicalPad::ancestor(std::size_t depth) {
+  LexicalPad *pad = this;
+  for (std::size_t i = 0; i < depth; i++) {
+    if (!pad->parent.has_value()) {
+      return nullptr;
+    }
+    pad = pad->parent.value().get();
+  }
+  return pad;
+}
+
 Value LexicalPad::get(const std::string &name) {
-  auto it = pad.find(name);
-  if (it == pad.end()) {
+  auto slot = find_slot(name);
+  if (!slot.has_value() || !slots[*slot].has_value()) {
     if (parent.has_value()) {
       return parent.value()->get(name);
     } else {
       return value::RuntimeError::NameError;
     }
   } else {
-    return it->second;
+    return *slots[*slot];
   }
 }
 
 Value LexicalPad::set(const std::string &name, Value v) {
-  auto it = pad.find(name);
-  if (it == pad.end()) {
+  auto slot = find_slot(name);
+  if (!slot.has_value() || !slots[*slot].has_value()) {
     if (parent.has_value()) {
       return parent.value()->set(name, v);
     } else {
       return value::RuntimeError::NameError;
     }
   } else {
-    Value old = it->second;
-    it->second = v;
+    Value old = *slots[*slot];
+    slots[*slot] = v;
     return old;
   }
 }
 
 void LexicalPad::initialize(const std::string &name, Value v) {
-  pad.insert({name, v});
+  auto slot = find_slot(name);
+  if (slot.has_value()) {
+    initialize(*slot, v);
+  } else {
+    extra_names.push_back(name);
+    slots.push_back(v);
+  }
 }
 
 void LexicalPad::initialize_global(const std::string &name, Value v) {
   if (parent.has_value()) {
     parent.value()->initialize_global(name, v);
   } else {
-    pad.insert({name, v});
+    initialize(name, v);
+  }
+}
+
+Value LexicalPad::get(const LexicalPadSlot &s, const std::string &name) {
+  LexicalPad *pad = ancestor(s.depth);
+  if (pad && s.slot < pad->slots.size() && pad->slots[s.slot].has_value()) {
+    return *pad->slots[s.slot];
+  } else {
+    return get(name);
+  }
+}
+
+Value LexicalPad::set(const LexicalPadSlot &s, const std::string &name,
+                      Value v) {
+  LexicalPad *pad = ancestor(s.depth);
+  if (pad && s.slot < pad->slots.size() && pad->slots[s.slot].has_value()) {
+    Value old = *pad->slots[s.slot];
+    pad->slots[s.slot] = v;
+    return old;
+  } else {
+    return set(name, v);
+  }
+}
+
+void LexicalPad::initialize(std::size_t slot, Value v) {
+  // like the name-based interface, initializing twice keeps the
+  // first value.
+  if (!slots[slot].has_value()) {
+    slots[slot] = v;
   }
 }
 
 Value LexicalPad::as_dict() const {
-  return value::Dictionary{
-      std::make_shared<std::unordered_map<std::string, Value>>(pad)};
+  value::Dictionary::Type members;
+  for (std::size_t i = 0; i < slots.size(); i++) {
+    if (slots[i].has_value()) {
+      members.insert({slot_name(i), *slots[i]});
+    }
+  }
+  return value::Dictionary{std::move(members)};
 }
 
 } // namespace networkprotocoldsl
@@ -3,25 +3,73 @@
 
 #include <networkprotocoldsl/value.hpp>
 
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace networkprotocoldsl {
 
+/**
+ * The names of the slots in a lexical pad, in slot order.
+ */
+using LexicalPadLayout = std::vector<std::string>;
+
+/**
+ * A variable resolved ahead of time: how many pads up the parent
+ * chain it lives, and which slot it occupies in that pad.
+ */
+struct LexicalPadSlot {
+  std::size_t depth;
+  std::size_t slot;
+};
+
+/**
+ * Describes a resolved slot for the stringify of the pad operations,
+ * or nothing if the operation still looks the variable up by name.
+ */
+std::string stringify_slot(const std::optional<LexicalPadSlot> &slot);
+
+/**
+ * A lexical pad holds the variables of one invocation in a fixed
+ * array of slots, sized from the layout of the callable when the pad
+ * is created. Operations resolved at generation time access the
+ * slots directly, while the name-based interface remains available
+ * for hand-built programs, globals and LexicalPadAsDict.
+ *
+ * A slot that was declared but not initialized behaves like a
+ * missing name, so lookups continue on the parent pad.
+ */
 class LexicalPad {
-  std::unordered_map<std::string, Value> pad;
+  std::shared_ptr<const LexicalPadLayout> layout;
+  // names initialized without being declared in the layout, such as
+  // globals, which get slots after the declared ones.
+  std::vector<std::string> extra_names;
+  std::pmr::vector<std::optional<Value>> slots;
   std::optional<std::shared_ptr<LexicalPad>> parent;
 
+  std::optional<std::size_t> find_slot(const std::string &name) const;
+  const std::string &slot_name(std::size_t slot) const;
+  LexicalPad *ancestor(std::size_t depth);
+
 public:
   LexicalPad(std::shared_ptr<LexicalPad> _parent) : parent(_parent) {}
+  LexicalPad(
+      std::shared_ptr<LexicalPad> _parent,
+      std::shared_ptr<const LexicalPadLayout> _layout,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : layout(_layout), slots(_layout->size(), resource), parent(_parent) {}
   LexicalPad() = default;
   ~LexicalPad() = default;
   Value get(const std::string &name);
   Value set(const std::string &name, Value v);
   void initialize(const std::string &name, Value v);
   void initialize_global(const std::string &name, Value v);
+  Value get(const LexicalPadSlot &s, const std::string &name);
+  Value set(const LexicalPadSlot &s, const std::string &name, Value v);
+  void initialize(std::size_t slot, Value v);
   Value as_dict() const;
 };
 
@@ -5,8 +5,14 @@
 
 namespace networkprotocoldsl::operation {
 
-Value DynamicList::operator()(std::shared_ptr<std::vector<Value>> args) const {
-  return value::DynamicList({args});
+Value DynamicList::operator()(std::span<const Value> args) const {
+  if (args.empty()) {
+    // such as the argument list of a call without arguments. Lists
+    // are immutable, so all the empty ones can share the storage.
+    static const auto empty = std::make_shared<const std::vector<Value>>();
+    return value::DynamicList(empty);
+  }
+  return value::DynamicList(std::vector<Value>(args.begin(), args.end()));
 }
 
 } // namespace networkprotocoldsl::operation
\ No newline at end of file
@@ -3,21 +3,36 @@
 
 #include <networkprotocoldsl/operationconcepts.hpp>
 
+#include <optional>
 #include <tuple>
 
 namespace networkprotocoldsl::operation {
 
+/**
+ * Reads a variable from the lexical pad. When the slot was resolved
+ * at generation time the pad is indexed directly, the name is only
+ * used when the slot was not initialized.
+ */
 class LexicalPadGet {
   std::string name;
+  std::optional<LexicalPadSlot> slot;
 
 public:
   using Arguments = std::tuple<>;
   LexicalPadGet(const std::string &n) : name(n){};
+  LexicalPadGet(const std::string &n, LexicalPadSlot s) : name(n), slot(s){};
   Value operator()(Arguments args, std::shared_ptr<LexicalPad> pad) const {
-    return pad->get(name);
+    if (slot.has_value()) {
+      return pad->get(slot.value(), name);
+    } else {
+      return pad->get(name);
+    }
   }
+  const std::string &get_name() const { return name; }
+  const std::optional<LexicalPadSlot> &get_slot() const { return slot; }
   std::string stringify() const {
-    return "LexicalPadGet{name: \"" + name + "\"}";
+    return "LexicalPadGet{name: \"" + name + "\"" + stringify_slot(slot) +
+           "}";
   }
 };
 static_assert(LexicalPadOperationConcept<LexicalPadGet>);
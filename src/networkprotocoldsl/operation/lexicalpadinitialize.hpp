@@ -3,22 +3,37 @@
 
 #include <networkprotocoldsl/operationconcepts.hpp>
 
+#include <optional>
 #include <tuple>
 
 namespace networkprotocoldsl::operation {
 
+/**
+ * Initializes a variable in the current lexical pad. Initialization
+ * always happens at depth 0, so only the slot is kept when resolved.
+ */
 class LexicalPadInitialize {
   std::string name;
+  std::optional<LexicalPadSlot> slot;
 
 public:
   using Arguments = std::tuple<Value>;
   LexicalPadInitialize(const std::string &n) : name(n){};
+  LexicalPadInitialize(const std::string &n, LexicalPadSlot s)
+      : name(n), slot(s){};
   Value operator()(Arguments args, std::shared_ptr<LexicalPad> pad) const {
-    pad->initialize(name, std::get<0>(args));
+    if (slot.has_value()) {
+      pad->initialize(slot.value().slot, std::get<0>(args));
+    } else {
+      pad->initialize(name, std::get<0>(args));
+    }
     return std::get<0>(args);
   }
+  const std::string &get_name() const { return name; }
+  const std::optional<LexicalPadSlot> &get_slot() const { return slot; }
   std::string stringify() const {
-    return "LexicalPadInitialize{name: \"" + name + "\"}";
+    return "LexicalPadInitialize{name: \"" + name + "\"" +
+           stringify_slot(slot) + "}";
   }
 };
 static_assert(LexicalPadOperationConcept<LexicalPadInitialize>);
@@ -3,21 +3,31 @@
 
 #include <networkprotocoldsl/operationconcepts.hpp>
 
+#include <optional>
 #include <tuple>
 
 namespace networkprotocoldsl::operation {
 
 class LexicalPadSet {
   std::string name;
+  std::optional<LexicalPadSlot> slot;
 
 public:
   using Arguments = std::tuple<Value>;
   LexicalPadSet(const std::string &n) : name(n){};
+  LexicalPadSet(const std::string &n, LexicalPadSlot s) : name(n), slot(s){};
   Value operator()(Arguments args, std::shared_ptr<LexicalPad> pad) const {
-    return pad->set(name, std::get<0>(args));
+    if (slot.has_value()) {
+      return pad->set(slot.value(), name, std::get<0>(args));
+    } else {
+      return pad->set(name, std::get<0>(args));
+    }
   }
+  const std::string &get_name() const { return name; }
+  const std::optional<LexicalPadSlot> &get_slot() const { return slot; }
   std::string stringify() const {
-    return "LexicalPadSet{name: \"" + name + "\"}";
+    return "LexicalPadSet{name: \"" + name + "\"" + stringify_slot(slot) +
+           "}";
   }
 };
 static_assert(LexicalPadOperationConcept<LexicalPadSet>);
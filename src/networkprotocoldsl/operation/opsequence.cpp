@@ -4,11 +4,11 @@
 
 namespace networkprotocoldsl::operation {
 
-Value OpSequence::operator()(std::shared_ptr<std::vector<Value>> args) const {
-  if (args->empty()) {
+Value OpSequence::operator()(std::span<const Value> args) const {
+  if (args.empty()) {
     return false;
   } else {
-    return args->back();
+    return args.back();
   }
 }
 
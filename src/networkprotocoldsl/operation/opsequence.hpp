@@ -20,7 +20,7 @@ namespace operation {
  */
 class OpSequence {
 public:
-  Value operator()(std::shared_ptr<std::vector<Value>> args) const;
+  Value operator()(std::span<const Value> args) const;
   std::string stringify() const { return "OpSequence{}"; }
 };
 static_assert(DynamicInputOperationConcept<OpSequence>);
@@ -1,17 +1,35 @@
 #include <networkprotocoldsl/operation/readoctetsuntilterminator.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <string_view>
 
 namespace networkprotocoldsl::operation {
 
+/**
+ * Keeps the value read as a slice of the input when it is reference
+ * counted, and copies it otherwise.
+ */
+static void capture(InputOutputOperationContext &ctx, std::string_view value) {
+  if (ctx.input && value.data() >= ctx.input->data() &&
+      value.data() + value.size() <= ctx.input->data() + ctx.input->size()) {
+    ctx.captured = value::Octets(ctx.input, value.data() - ctx.input->data(),
+                                 value.size());
+  } else {
+    ctx.buffer.assign(value);
+  }
+}
+
 OperationResult
 ReadOctetsUntilTerminator::operator()(InputOutputOperationContext &ctx,
                                       Arguments a) const {
   if (ctx.ready) {
-    return value::Octets{std::make_shared<const std::string>(ctx.buffer)};
+    if (ctx.captured.has_value()) {
+      return *ctx.captured;
+    }
+    return value::Octets{std::move(ctx.buffer)};
   } else if (ctx.eof) {
     return value::RuntimeError::ProtocolMismatchError;
   } else {
@@ -19,8 +37,29 @@ ReadOctetsUntilTerminator::operator()(InputOutputOperationContext &ctx,
   }
 }
 
+/**
+ * How much of the input, from pos on, can be consumed when no pattern
+ * was found in it: everything except the last bytes, which may be the
+ * start of a pattern whose rest has not arrived yet. Those are looked
+ * at again with the next input, which keeps the scan linear no matter
+ * how many reads the value arrives in.
+ */
+static size_t safe_to_consume(std::string_view in, size_t pos,
+                              size_t longest_pattern) {
+  size_t keep = longest_pattern > 0 ? longest_pattern - 1 : 0;
+  if (in.size() <= pos + keep) {
+    return pos;
+  }
+  return in.size() - keep;
+}
+
 size_t ReadOctetsUntilTerminator::handle_read(InputOutputOperationContext &ctx,
                                               std::string_view in) const {
+  // Whatever was consumed by the previous reads is already in the
+  // buffer, so each byte is only scanned again if it could be the
+  // start of a terminator or escape sequence cut at the end of the
+  // input.
+  //
   // Escape replacement algorithm:
   // When reading, we search for both the terminator and the escape_sequence.
   // If we find escape_sequence first (or at the same position as terminator),
@@ -30,56 +69,54 @@ size_t ReadOctetsUntilTerminator::handle_read(InputOutputOperationContext &ctx,
   if (escape_char.has_value() && escape_sequence.has_value()) {
     size_t pos = 0;
     while (pos < in.size()) {
-      // Find the earliest occurrence of terminator or escape_sequence
-      auto term_pos = in.find(terminator, pos);
-      auto esc_pos = in.find(*escape_sequence, pos);
-      
-      if (term_pos == in.npos && esc_pos == in.npos) {
-        // Neither found yet - need more data
-        return 0;
-      }
-      
-      // Determine whether to handle escape sequence or terminator.
-      // Priority rules:
-      // 1. If only escape found -> handle escape
-      // 2. If escape found before terminator -> handle escape
-      // 3. If escape and terminator at same position -> prefer escape
-      //    (escape_sequence is longer and contains terminator as prefix)
-      // 4. Otherwise -> handle terminator
-      bool prefer_escape = false;
-      if (esc_pos != in.npos) {
-        if (term_pos == in.npos || esc_pos < term_pos || esc_pos == term_pos) {
-          prefer_escape = true;
-        }
+      // The earliest of the terminator and the escape sequence, where
+      // the escape sequence wins if both start at the same position
+      // (it is longer and contains the terminator as prefix).
+      auto match = scanner.find(in, pos);
+      if (match.position == in.npos) {
+        // Neither found yet - keep what can't be part of either
+        break;
       }
-      
-      if (prefer_escape) {
+
+      if (match.pattern == 0) {
         // Escape sequence found before terminator
         // Append data up to escape sequence, then the escape character
-        ctx.buffer.append(in.begin() + pos, in.begin() + esc_pos);
+        ctx.buffer.append(in.begin() + pos, in.begin() + match.position);
         ctx.buffer.append(*escape_char);
-        pos = esc_pos + escape_sequence->size();
+        pos = match.position + escape_sequence->size();
         continue;
       }
-      
+
       // Terminator found (and it's before any escape sequence)
-      ctx.buffer.append(in.begin() + pos, in.begin() + term_pos);
+      if (pos == 0 && ctx.buffer.empty()) {
+        // no escape sequence was replaced, the bytes are unchanged.
+        capture(ctx, in.substr(0, match.position));
+      } else {
+        ctx.buffer.append(in.begin() + pos, in.begin() + match.position);
+      }
       ctx.ready = true;
-      return term_pos + terminator.size();
+      return match.position + terminator.size();
     }
-    // We processed the whole input but didn't find terminator
-    return 0;
+    size_t consumed = safe_to_consume(
+        in, pos, std::max(terminator.size(), escape_sequence->size()));
+    ctx.buffer.append(in.begin() + pos, in.begin() + consumed);
+    return consumed;
   }
-  
+
   // No escape handling - simple case
-  auto pos = in.find(terminator);
+  auto pos = scanner.find(in).position;
   if (pos == in.npos) {
-    return 0;
+    size_t consumed = safe_to_consume(in, 0, terminator.size());
+    ctx.buffer.append(in.substr(0, consumed));
+    return consumed;
+  }
+  if (ctx.buffer.empty()) {
+    capture(ctx, in.substr(0, pos));
   } else {
-    ctx.buffer = std::string(in.begin(), pos);
-    ctx.ready = true;
-    return pos + terminator.size();
+    ctx.buffer.append(in.substr(0, pos));
   }
+  ctx.ready = true;
+  return pos + terminator.size();
 }
 
 void ReadOctetsUntilTerminator::handle_eof(
@@ -2,6 +2,7 @@
 #define NETWORKPROTOCOLDSL_OPERATION_READOCTETSUNTILTERMINATOR_HPP
 
 #include <networkprotocoldsl/operationconcepts.hpp>
+#include <networkprotocoldsl/support/patternscanner.hpp>
 #include <networkprotocoldsl/value.hpp>
 
 #include <cstdint>
@@ -21,15 +22,21 @@ class ReadOctetsUntilTerminator {
   // it is replaced with escape_char in the captured value
   const std::optional<std::string> escape_char;
   const std::optional<std::string> escape_sequence;
+  // Looks for the escape sequence, when there is one, and the
+  // terminator in the same pass. The escape sequence goes first, so
+  // it wins when both start at the same place.
+  const support::PatternScanner scanner;
 
 public:
   using Arguments = std::tuple<>;
-  ReadOctetsUntilTerminator(const std::string &_t) : terminator(_t) {}
+  ReadOctetsUntilTerminator(const std::string &_t)
+      : terminator(_t), scanner({terminator}) {}
   ReadOctetsUntilTerminator(const std::string &_t,
                             const std::string &_escape_char,
                             const std::string &_escape_sequence)
       : terminator(_t), escape_char(_escape_char),
-        escape_sequence(_escape_sequence) {}
+        escape_sequence(_escape_sequence),
+        scanner({_escape_sequence, terminator}) {}
 
   OperationResult operator()(InputOutputOperationContext &ctx,
                              Arguments a) const;
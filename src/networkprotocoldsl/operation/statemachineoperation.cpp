@@ -2,9 +2,11 @@
 
 #include <networkprotocoldsl/operation/staticcallable.hpp>
 #include <networkprotocoldsl/operationconcepts.hpp>
+#include <networkprotocoldsl/optree.hpp>
 #include <networkprotocoldsl/print_optreenode.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <algorithm>
 #include <ostream>
 #include <thread>
 
@@ -24,21 +26,94 @@ enum class ProcessingMode {
   State,
 };
 
-using StatePair = std::pair<std::string, StateMachineOperation::StateInfo>;
-using TransitionPair =
-    std::pair<std::string, StateMachineOperation::TransitionInfo>;
+using InternedStates = StateMachineOperation::InternedStates;
 
 struct ProcessingInfo {
   ProcessingMode processing_mode;
-  std::optional<StatePair> from_state;
-  std::optional<TransitionPair> transition;
-  StatePair to_state;
+  const StateMachineOperation::InternedTransition *transition;
+  std::size_t to_state;
 };
 
 } // namespace
 
 namespace networkprotocoldsl::operation {
 
+const std::vector<std::string> &StateMachineOperation::state_argument_names() {
+  static const std::vector<std::string> names = {"dictionary"};
+  return names;
+}
+
+StateMachineOperation::TransitionIds StateMachineOperation::transition_ids(
+    const StateTransitionMap &transitions) {
+  std::vector<std::string> names;
+  names.reserve(transitions.size());
+  for (const auto &[name, transition] : transitions) {
+    names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  TransitionIds ids;
+  for (std::size_t i = 0; i < names.size(); i++) {
+    ids[names[i]] = static_cast<int32_t>(i);
+  }
+  return ids;
+}
+
+StateMachineOperation::StateMachineOperation(StateMap s) {
+  auto i = std::make_shared<InternedStates>();
+  i->states = std::move(s);
+  auto &states = i->states;
+  // the pads of the callbacks have the same layout every time, so
+  // work it out once here instead of on each transition.
+  for (auto &[state_name, state] : states) {
+    if (state.callback_optree && !state.pad_layout) {
+      state.pad_layout =
+          state.callback_optree->pad_layout(state_argument_names());
+    }
+    for (auto &[transition_name, transition] : state.transitions) {
+      if (transition.callback_optree && !transition.pad_layout) {
+        transition.pad_layout =
+            transition.callback_optree->pad_layout(transition.argument_names);
+      }
+    }
+  }
+
+  std::vector<std::string> state_names;
+  state_names.reserve(states.size());
+  for (const auto &[state_name, state] : states) {
+    state_names.push_back(state_name);
+  }
+  std::sort(state_names.begin(), state_names.end());
+  std::unordered_map<std::string, std::size_t> state_ids;
+  for (std::size_t id = 0; id < state_names.size(); id++) {
+    state_ids[state_names[id]] = id;
+  }
+  i->by_id.resize(state_names.size());
+  for (std::size_t id = 0; id < state_names.size(); id++) {
+    const auto &state = states.at(state_names[id]);
+    auto &interned_state = i->by_id[id];
+    interned_state.info = &state;
+    interned_state.transition_ids = transition_ids(state.transitions);
+    interned_state.transitions.resize(state.transitions.size());
+    for (const auto &[transition_name, transition] : state.transitions) {
+      auto &interned_transition =
+          interned_state.transitions[interned_state.transition_ids.at(
+              transition_name)];
+      interned_transition.info = &transition;
+      auto target = state_ids.find(transition.target_state);
+      if (target != state_ids.end()) {
+        interned_transition.target_state = target->second;
+      }
+    }
+  }
+  if (auto it = state_ids.find("Open"); it != state_ids.end()) {
+    i->open_state = it->second;
+  }
+  if (auto it = state_ids.find("Closed"); it != state_ids.end()) {
+    i->closed_state = it->second;
+  }
+  interned = std::move(i);
+}
+
 static std::optional<std::shared_ptr<std::vector<Value>>>
 _extract_arguments(const std::vector<std::string> &names,
                    const value::Dictionary &d) {
@@ -57,11 +132,14 @@ _extract_arguments(const std::vector<std::string> &names,
 
 static OperationResult
 _start_state_callback(ControlFlowOperationContext &ctx,
-                      const StateMachineOperation::StateMap &states) {
+                      const InternedStates &states) {
   DEBUG("Entering _start_state_callback");
   ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
-  auto &s = info.to_state.second;
-  ctx.callable = value::Callable{s.callback_optree, {"dictionary"}, true};
+  const auto &s = *states.by_id[info.to_state].info;
+  ctx.callable =
+      value::Callable{s.callback_optree,
+                      StateMachineOperation::state_argument_names(), true,
+                      s.pad_layout};
   ctx.value = std::nullopt;
   info.processing_mode = ProcessingMode::State;
   return ReasonForBlockedOperation::WaitingForCallableInvocation;
@@ -69,51 +147,80 @@ _start_state_callback(ControlFlowOperationContext &ctx,
 
 static OperationResult
 _start_transition_callback(ControlFlowOperationContext &ctx,
-                           const StateMachineOperation::StateMap &states) {
+                           const InternedStates &states) {
   DEBUG("Entering _start_transition_callback");
   ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
-  assert(info.transition.has_value());
-  auto &t = info.transition.value().second;
-  ctx.callable = value::Callable{t.callback_optree, t.argument_names, true};
+  assert(info.transition);
+  const auto &t = *info.transition->info;
+  ctx.callable = value::Callable{t.callback_optree, t.argument_names, true,
+                                 t.pad_layout};
   ctx.value = std::nullopt;
   info.processing_mode = ProcessingMode::Transition;
   return ReasonForBlockedOperation::WaitingForCallableInvocation;
 }
 
 static OperationResult
-_process_state_return_with_args(ControlFlowOperationContext &ctx,
-                                const StateMachineOperation::StateMap &states,
-                                const value::Octets t,
-                                const value::Dictionary d) {
-  DEBUG("Entering _process_state_return_with_args (Octets, Dictionary)");
+_take_transition(ControlFlowOperationContext &ctx, const InternedStates &states,
+                 std::size_t transition_id, const value::Dictionary &d) {
+  DEBUG("Entering _take_transition");
   ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
-  if (info.to_state.first == "Closed") {
-    return d;
-  }
-  auto &s = info.to_state.second;
-  info.from_state = info.to_state;
-  auto it = s.transitions.find(*t.data);
-  if (it == s.transitions.end()) {
+  const auto &t = states.by_id[info.to_state].transitions[transition_id];
+  if (!t.target_state.has_value()) {
     return value::RuntimeError::NameError;
   }
-  auto target_state_name = it->second.target_state;
-  auto it2 = states.find(target_state_name);
-  if (it2 == states.end()) {
-    return value::RuntimeError::NameError;
-  }
-  auto maybe_args = _extract_arguments(it->second.argument_names, d);
+  auto maybe_args = _extract_arguments(t.info->argument_names, d);
   if (!maybe_args.has_value()) {
     return value::RuntimeError::TypeError;
   }
   ctx.accumulator = maybe_args.value();
-  info.transition = *it;
-  info.to_state = *it2;
+  info.transition = &t;
+  info.to_state = *t.target_state;
   return _start_transition_callback(ctx, states);
 }
 
+static bool _is_closed(ControlFlowOperationContext &ctx,
+                       const InternedStates &states) {
+  ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
+  return info.to_state == states.closed_state;
+}
+
+static OperationResult
+_process_state_return_with_args(ControlFlowOperationContext &ctx,
+                                const InternedStates &states,
+                                const int32_t t, const value::Dictionary d) {
+  DEBUG("Entering _process_state_return_with_args (int32_t, Dictionary)");
+  if (_is_closed(ctx, states)) {
+    return d;
+  }
+  ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
+  if (t < 0 || static_cast<std::size_t>(t) >=
+                   states.by_id[info.to_state].transitions.size()) {
+    return value::RuntimeError::NameError;
+  }
+  return _take_transition(ctx, states, t, d);
+}
+
+static OperationResult
+_process_state_return_with_args(ControlFlowOperationContext &ctx,
+                                const InternedStates &states,
+                                const value::Octets t,
+                                const value::Dictionary d) {
+  DEBUG("Entering _process_state_return_with_args (Octets, Dictionary)");
+  if (_is_closed(ctx, states)) {
+    return d;
+  }
+  ProcessingInfo &info = std::any_cast<ProcessingInfo &>(ctx.additional_info);
+  const auto &ids = states.by_id[info.to_state].transition_ids;
+  auto it = ids.find(*t.data);
+  if (it == ids.end()) {
+    return value::RuntimeError::NameError;
+  }
+  return _take_transition(ctx, states, it->second, d);
+}
+
 static OperationResult
 _process_state_return_with_args(ControlFlowOperationContext &ctx,
-                                const StateMachineOperation::StateMap &states,
+                                const InternedStates &states,
                                 const auto &, const auto &) {
   DEBUG("Entering _process_state_return_with_args (auto, auto)");
   return value::RuntimeError::TypeError;
@@ -121,7 +228,7 @@ _process_state_return_with_args(ControlFlowOperationContext &ctx,
 
 static OperationResult
 _process_state_return_dynlist(ControlFlowOperationContext &ctx,
-                              const StateMachineOperation::StateMap &states,
+                              const InternedStates &states,
                               const value::DynamicList v) {
   DEBUG("Entering _process_state_return_dynlist (DynamicList)");
   if (v.values->size() != 2) {
@@ -136,7 +243,7 @@ _process_state_return_dynlist(ControlFlowOperationContext &ctx,
 
 static OperationResult
 _process_state_return_dynlist(ControlFlowOperationContext &ctx,
-                              const StateMachineOperation::StateMap &states,
+                              const InternedStates &states,
                               const value::RuntimeError err) {
   DEBUG("Entering _process_state_return_dynlist (RuntimeError)");
   return err;
@@ -144,7 +251,7 @@ _process_state_return_dynlist(ControlFlowOperationContext &ctx,
 
 static OperationResult
 _process_state_return_dynlist(ControlFlowOperationContext &ctx,
-                              const StateMachineOperation::StateMap &states,
+                              const InternedStates &states,
                               const auto &) {
   DEBUG("Entering _process_state_return_dynlist (auto)");
   return value::RuntimeError::TypeError;
@@ -152,7 +259,7 @@ _process_state_return_dynlist(ControlFlowOperationContext &ctx,
 
 static OperationResult
 _process_state_return(ControlFlowOperationContext &ctx,
-                      const StateMachineOperation::StateMap &states) {
+                      const InternedStates &states) {
   DEBUG("Entering _process_state_return");
   assert(ctx.value.has_value());
   return std::visit(
@@ -162,7 +269,7 @@ _process_state_return(ControlFlowOperationContext &ctx,
 
 static OperationResult _process_transition_return_with_args(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states, const value::Dictionary &d) {
+    const InternedStates &states, const value::Dictionary &d) {
   DEBUG("Entering _process_transition_return_with_args (Dictionary)");
   ctx.accumulator = std::make_shared<std::vector<Value>>(std::vector<Value>{d});
   return _start_state_callback(ctx, states);
@@ -170,7 +277,7 @@ static OperationResult _process_transition_return_with_args(
 
 static OperationResult _process_transition_return_with_args(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states,
+    const InternedStates &states,
     const value::RuntimeError &err) {
   DEBUG("Entering _process_transition_return_with_args (RuntimeError)");
   return err;
@@ -178,14 +285,14 @@ static OperationResult _process_transition_return_with_args(
 
 static OperationResult _process_transition_return_with_args(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states, const auto &) {
+    const InternedStates &states, const auto &) {
   DEBUG("Entering _process_transition_return_with_args (auto)");
   return value::RuntimeError::TypeError;
 }
 
 static OperationResult _process_transition_return_dynlist(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states,
+    const InternedStates &states,
     const value::DynamicList &l) {
   DEBUG("Entering _process_transition_return_dynlist (DynamicList)");
   if (l.values->size() != 1) {
@@ -200,7 +307,7 @@ static OperationResult _process_transition_return_dynlist(
 
 static OperationResult _process_transition_return_dynlist(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states,
+    const InternedStates &states,
     const value::RuntimeError err) {
   DEBUG("Entering _process_transition_return_dynlist (RuntimeError)");
   return err;
@@ -208,14 +315,14 @@ static OperationResult _process_transition_return_dynlist(
 
 static OperationResult _process_transition_return_dynlist(
     ControlFlowOperationContext &ctx,
-    const StateMachineOperation::StateMap &states, const auto &) {
+    const InternedStates &states, const auto &) {
   DEBUG("Entering _process_transition_return_dynlist (auto)");
   return value::RuntimeError::TypeError;
 }
 
 static OperationResult
 _process_transition_return(ControlFlowOperationContext &ctx,
-                           const StateMachineOperation::StateMap &states) {
+                           const InternedStates &states) {
   DEBUG("Entering _process_transition_return");
   assert(ctx.value.has_value());
   return std::visit(
@@ -235,12 +342,12 @@ StateMachineOperation::operator()(ControlFlowOperationContext &ctx,
         ProcessingInfo &info =
             std::any_cast<ProcessingInfo &>(ctx.additional_info);
         if (info.processing_mode == ProcessingMode::Transition) {
-          if (!info.transition.has_value()) {
+          if (!info.transition) {
             return value::RuntimeError::NameError;
           }
-          return _process_transition_return(ctx, states);
+          return _process_transition_return(ctx, *interned);
         } else {
-          return _process_state_return(ctx, states);
+          return _process_state_return(ctx, *interned);
         }
       } else {
         return ReasonForBlockedOperation::WaitingForCallableResult;
@@ -249,15 +356,14 @@ StateMachineOperation::operator()(ControlFlowOperationContext &ctx,
       return ReasonForBlockedOperation::WaitingForCallableInvocation;
     }
   } else {
-    auto it = states.find("Open");
-    if (it == states.end()) {
+    if (!interned->open_state.has_value()) {
       return value::RuntimeError::NameError;
     }
     ctx.accumulator = std::make_shared<std::vector<Value>>(
         std::vector<Value>{value::Dictionary()});
-    ctx.additional_info = ProcessingInfo{ProcessingMode::Transition,
-                                         std::nullopt, std::nullopt, *it};
-    return _start_state_callback(ctx, states);
+    ctx.additional_info = ProcessingInfo{ProcessingMode::Transition, nullptr,
+                                         *interned->open_state};
+    return _start_state_callback(ctx, *interned);
   }
 }
 
@@ -291,7 +397,7 @@ std::string StateMachineOperation::stringify() const {
   DEBUG("Entering StateMachineOperation::stringify");
   std::ostringstream os;
   os << "StateMachineOperation{\n";
-  for (const auto &[state_name, state_info] : states) {
+  for (const auto &[state_name, state_info] : interned->states) {
     os << "  State: " << state_name << "\n";
     os << "    Callback Optree:\n";
     if (state_info.callback_optree) {
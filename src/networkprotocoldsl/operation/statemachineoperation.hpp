@@ -3,6 +3,7 @@
 
 #include <any>
 #include <networkprotocoldsl/operationconcepts.hpp>
+#include <optional>
 #include <sstream> // Added for std::ostringstream
 #include <unordered_map>
 
@@ -18,6 +19,8 @@ public:
     std::shared_ptr<const OpTree> callback_optree;
     std::vector<std::string> argument_names;
     std::string target_state;
+    // filled in by the constructor when not provided.
+    std::shared_ptr<const LexicalPadLayout> pad_layout;
   };
 
   using StateTransitionMap = std::unordered_map<std::string, TransitionInfo>;
@@ -25,13 +28,24 @@ public:
   struct StateInfo {
     std::shared_ptr<const OpTree> callback_optree;
     StateTransitionMap transitions;
+    // filled in by the constructor when not provided.
+    std::shared_ptr<const LexicalPadLayout> pad_layout;
   };
 
   using StateMap = std::unordered_map<std::string, StateInfo>;
 
+  /**
+   * Transitions are addressed by their position among the names of
+   * the transitions of the state, in sorted order. A state callback
+   * can return that ID instead of the transition name, which spares
+   * the lookup by name.
+   */
+  using TransitionIds = std::unordered_map<std::string, int32_t>;
+  static TransitionIds transition_ids(const StateTransitionMap &transitions);
+
   using Arguments = std::tuple<>;
 
-  StateMachineOperation(StateMap states) : states(states) {}
+  StateMachineOperation(StateMap states);
   OperationResult operator()(ControlFlowOperationContext &ctx,
                              Arguments a) const;
   Value get_callable(ControlFlowOperationContext &ctx) const;
@@ -40,9 +54,44 @@ public:
   void set_callable_invoked(ControlFlowOperationContext &ctx) const;
   void set_callable_return(ControlFlowOperationContext &ctx, Value v) const;
   std::string stringify() const;
+  const StateMap &get_states() const { return interned->states; }
+
+  /**
+   * The state callbacks are invoked with the dictionary produced by
+   * the previous transition as their only argument.
+   */
+  static const std::vector<std::string> &state_argument_names();
+
+  struct InternedTransition {
+    const TransitionInfo *info;
+    // the ID of the target state, if there is such a state.
+    std::optional<std::size_t> target_state;
+  };
+
+  struct InternedState {
+    const StateInfo *info;
+    std::vector<InternedTransition> transitions;
+    TransitionIds transition_ids;
+  };
+
+  /**
+   * The states and transitions resolved to dense IDs, so running the
+   * state machine does not look anything up by name. States have IDs
+   * in the sorted order of their names, like transitions.
+   */
+  struct InternedStates {
+    InternedStates() = default;
+    // the IDs point into the map, so it stays where it was built.
+    InternedStates(const InternedStates &) = delete;
+    StateMap states;
+    std::vector<InternedState> by_id;
+    std::optional<std::size_t> open_state;
+    std::optional<std::size_t> closed_state;
+  };
 
 private:
-  StateMap states;
+  // shared so that copies of the operation don't rebuild it.
+  std::shared_ptr<const InternedStates> interned;
 };
 static_assert(ControlFlowOperationConcept<StateMachineOperation>);
 
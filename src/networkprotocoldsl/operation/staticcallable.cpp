@@ -1,10 +1,20 @@
 #include <networkprotocoldsl/operation/staticcallable.hpp>
+#include <networkprotocoldsl/optree.hpp>
 #include <networkprotocoldsl/print_optreenode.hpp>
 
 namespace networkprotocoldsl::operation {
 
+StaticCallable::StaticCallable(std::shared_ptr<OpTree> o)
+    : StaticCallable(o, {}, true) {}
+
+StaticCallable::StaticCallable(std::shared_ptr<OpTree> o,
+                               const std::vector<std::string> &n, bool i)
+    : optree(o), argument_names(n), inherits_lexical_pad(i),
+      pad_layout(o->pad_layout(n)) {}
+
 Value StaticCallable::operator()(Arguments a) const {
-  return value::Callable(optree, argument_names, inherits_lexical_pad);
+  return value::Callable(optree, argument_names, inherits_lexical_pad,
+                         pad_layout);
 }
 
 std::string StaticCallable::stringify() const {
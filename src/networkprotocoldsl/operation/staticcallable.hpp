@@ -18,15 +18,19 @@ class StaticCallable {
   std::shared_ptr<OpTree> optree;
   std::vector<std::string> argument_names;
   bool inherits_lexical_pad;
+  std::shared_ptr<const LexicalPadLayout> pad_layout;
 
 public:
-  StaticCallable(std::shared_ptr<OpTree> o)
-      : optree(o), argument_names({}), inherits_lexical_pad(true) {}
+  StaticCallable(std::shared_ptr<OpTree> o);
   StaticCallable(std::shared_ptr<OpTree> o, const std::vector<std::string> &n,
-                 bool i)
-      : optree(o), argument_names(n), inherits_lexical_pad(i) {}
+                 bool i);
   using Arguments = std::tuple<>;
   Value operator()(Arguments a) const;
+  const std::shared_ptr<OpTree> &get_optree() const { return optree; }
+  const std::vector<std::string> &get_argument_names() const {
+    return argument_names;
+  }
+  bool get_inherits_lexical_pad() const { return inherits_lexical_pad; }
   std::string stringify() const;
 };
 static_assert(InterpretedOperationConcept<StaticCallable>);
@@ -1,26 +1,125 @@
 #include "transitionlookahead.hpp"
 
+#include <algorithm>
+#include <utility>
+
 namespace networkprotocoldsl {
 namespace operation {
 
-OperationResult
-TransitionLookahead::operator()(InputOutputOperationContext &ctx,
-                                const Arguments &) const {
-  bool all_permanently_invalid = true;
-  for (const auto &condition : conditions) {
-    const auto &cond = condition.first;
-    const auto &target_state = condition.second;
+TransitionLookahead::Compiled
+TransitionLookahead::compile(const Conditions &conditions) {
+  std::vector<std::string> patterns;
+  std::vector<std::string> strings;
+  std::vector<std::size_t> string_conditions;
+  std::vector<std::pair<std::size_t, std::size_t>> terminator_conditions;
+  std::vector<std::size_t> eof_conditions;
+  for (std::size_t i = 0; i < conditions.size(); i++) {
+    const auto &cond = conditions[i].first;
+    if (const auto *c = std::get_if<MatchUntilTerminator>(&cond)) {
+      auto it = std::find(patterns.begin(), patterns.end(), c->terminator);
+      if (it == patterns.end()) {
+        it = patterns.insert(it, c->terminator);
+      }
+      terminator_conditions.emplace_back(i, it - patterns.begin());
+    } else if (const auto *c = std::get_if<std::string>(&cond)) {
+      strings.push_back(*c);
+      string_conditions.push_back(i);
+    } else {
+      eof_conditions.push_back(i);
+    }
+  }
+  return {support::PatternScanner(std::move(patterns)),
+          support::PrefixTrie(strings), std::move(string_conditions),
+          std::move(terminator_conditions), std::move(eof_conditions)};
+}
+
+void TransitionLookahead::advance(InputOutputOperationContext &ctx,
+                                  std::string_view in) const {
+  auto &progress = ctx.lookahead;
+  if (in.size() <= progress.seen) {
+    return;
+  }
+  const auto &terminators = compiled.terminators;
+  const auto &patterns = terminators.get_patterns();
+  std::uint64_t all_terminators =
+      patterns.size() == support::PatternScanner::max_patterns
+          ? ~std::uint64_t(0)
+          : (std::uint64_t(1) << patterns.size()) - 1;
+  if (!patterns.empty() && progress.terminators_found != all_terminators) {
+    // a terminator may have started in the last bytes seen before.
+    std::size_t overlap = terminators.longest_pattern() - 1;
+    std::size_t from = progress.seen > overlap ? progress.seen - overlap : 0;
+    progress.terminators_found |= terminators.occurring(in.substr(from));
+  }
+  progress.trie_state = compiled.strings.walk(
+      progress.trie_state, in.substr(progress.seen), progress.passed_string);
+  progress.seen = in.size();
+}
+
+TransitionLookahead::Evaluation
+TransitionLookahead::evaluate(InputOutputOperationContext &ctx) const {
+  const auto &progress = ctx.lookahead;
+  constexpr std::size_t none = static_cast<std::size_t>(-1);
+  // the first condition, in the order they are listed, that matches.
+  std::size_t first_valid = none;
+  std::size_t still_possible = 0;
+  std::size_t last_possible = none;
+
+  // a static string matches once the input went past it, and the ones
+  // the input is still a prefix of need more of it.
+  if (progress.passed_string != support::PrefixTrie::npos) {
+    first_valid = compiled.string_conditions[progress.passed_string];
+  }
+  if (!ctx.eof) {
+    std::size_t reachable = compiled.strings.reachable(progress.trie_state);
+    still_possible += reachable;
+    if (reachable == 1) {
+      last_possible = compiled.string_conditions[compiled.strings.only_reachable(
+          progress.trie_state)];
+    }
+  }
 
-    auto [is_valid, is_permanently_invalid] = std::visit(
-        [&](const auto &c) { return match_condition(ctx, c); }, cond);
-    if (is_valid) {
-      return value::Octets{std::make_shared<std::string>(target_state)};
+  for (const auto &[condition, terminator] : compiled.terminator_conditions) {
+    if (progress.terminators_found & (std::uint64_t(1) << terminator)) {
+      first_valid = std::min(first_valid, condition);
+    } else if (!ctx.eof) {
+      still_possible++;
+      last_possible = condition;
     }
-    if (!is_permanently_invalid) {
-      all_permanently_invalid = false;
+  }
+
+  // the end of the input can't be taken before it happened, so it is
+  // never the one condition left that decides the transition.
+  bool eof_possible = false;
+  for (std::size_t condition : compiled.eof_conditions) {
+    if (progress.seen == 0) {
+      if (ctx.eof) {
+        first_valid = std::min(first_valid, condition);
+      } else {
+        eof_possible = true;
+      }
     }
   }
-  if (all_permanently_invalid) {
+
+  if (first_valid != none) {
+    return {conditions[first_valid].second, false};
+  }
+  // Once the input began, and nothing else can match, the transition
+  // is decided even though its condition isn't complete yet.
+  if (still_possible == 1 && !eof_possible && progress.seen > 0) {
+    return {conditions[last_possible].second, false};
+  }
+  return {std::nullopt, still_possible == 0 && !eof_possible};
+}
+
+OperationResult
+TransitionLookahead::operator()(InputOutputOperationContext &ctx,
+                                const Arguments &) const {
+  auto evaluation = evaluate(ctx);
+  if (evaluation.transition.has_value()) {
+    return *evaluation.transition;
+  }
+  if (evaluation.all_permanently_invalid) {
     return value::RuntimeError::ProtocolMismatchError;
   }
   return ReasonForBlockedOperation::WaitingForRead;
@@ -28,7 +127,7 @@ TransitionLookahead::operator()(InputOutputOperationContext &ctx,
 
 std::size_t TransitionLookahead::handle_read(InputOutputOperationContext &ctx,
                                              std::string_view sv) const {
-  ctx.buffer = sv;
+  advance(ctx, sv);
   return 0;
 }
 
@@ -63,50 +162,6 @@ std::string TransitionLookahead::stringify() const {
   return result;
 }
 
-std::pair<bool, bool>
-TransitionLookahead::match_condition(InputOutputOperationContext &ctx,
-                                     const EOFCondition &) {
-  if (ctx.buffer.empty()) {
-    if (ctx.eof) {
-      return {true, true};
-    } else {
-      return {false, false};
-    }
-  } else {
-    return {false, true};
-  }
-}
-
-std::pair<bool, bool>
-TransitionLookahead::match_condition(InputOutputOperationContext &ctx,
-                                     const MatchUntilTerminator &c) {
-  auto it = ctx.buffer.find(c.terminator);
-  if (it != std::string::npos) {
-    return {true, false};
-  } else {
-    return {false, ctx.eof};
-  }
-}
-
-std::pair<bool, bool>
-TransitionLookahead::match_condition(InputOutputOperationContext &ctx,
-                                     const std::string &c) {
-  if (ctx.buffer.size() <= c.size()) {
-    if (ctx.buffer.compare(0, ctx.buffer.size(),
-                           c.substr(0, ctx.buffer.size())) != 0) {
-      return {false, true};
-    } else {
-      return {false, ctx.eof};
-    }
-  } else {
-    if (ctx.buffer.compare(0, c.size(), c) == 0) {
-      return {true, false};
-    } else {
-      return {false, true};
-    }
-  }
-}
-
 std::string TransitionLookahead::condition_to_string(const EOFCondition &) {
   return "EOF";
 }
@@ -124,21 +179,9 @@ bool TransitionLookahead::ready_to_evaluate(
     InputOutputOperationContext &ctx) const {
   // The operation is ready when we can definitively decide:
   // either a condition matches, or all conditions are permanently invalid
-  bool all_permanently_invalid = true;
-  for (const auto &condition : conditions) {
-    const auto &cond = condition.first;
-
-    auto [is_valid, is_permanently_invalid] = std::visit(
-        [&](const auto &c) { return match_condition(ctx, c); }, cond);
-    if (is_valid) {
-      return true; // Found a match, we're ready
-    }
-    if (!is_permanently_invalid) {
-      all_permanently_invalid = false;
-    }
-  }
-  // Ready if all conditions are permanently invalid (will return error)
-  return all_permanently_invalid;
+  auto evaluation = evaluate(ctx);
+  return evaluation.transition.has_value() ||
+         evaluation.all_permanently_invalid;
 }
 
 } // namespace operation
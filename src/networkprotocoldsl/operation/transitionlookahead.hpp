@@ -2,17 +2,38 @@
 #define NETWORKPROTOCOLDSL_OPERATION_TRANSITIONLOOKAHEAD_HPP
 
 #include <networkprotocoldsl/operationconcepts.hpp>
+#include <networkprotocoldsl/support/patternscanner.hpp>
+#include <networkprotocoldsl/support/prefixtrie.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <cstdint>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace networkprotocoldsl {
 namespace operation {
 
+/**
+ * Decides which transition the input that arrived selects, without
+ * consuming any of it.
+ *
+ * The input isn't copied. Each read looks at what arrived since the
+ * previous one and remembers, in the context, how far the input got in
+ * the trie of the static strings and which terminators were found, so
+ * the operation can be evaluated without the input at all. As soon as
+ * a single condition can still match, its transition is taken, and the
+ * reads of that transition check the rest.
+ *
+ * The conditions are compiled once, when the operation is built for
+ * its state, so that neither reading nor evaluating depends on how
+ * many static strings there are. Neither of them changes afterwards,
+ * so they can't disagree.
+ */
 struct TransitionLookahead {
   struct EOFCondition {};
 
@@ -23,11 +44,31 @@ struct TransitionLookahead {
   using TransitionCondition =
       std::variant<EOFCondition, MatchUntilTerminator, std::string>;
 
-  std::vector<std::pair<TransitionCondition, std::string>>
-      conditions; // pair of condition and target state
+  using Conditions = std::vector<std::pair<TransitionCondition, int32_t>>;
+
+  // pair of condition and the ID of the transition it selects, see
+  // StateMachineOperation::transition_ids.
+  const Conditions conditions;
+
+  struct Compiled {
+    // The terminators of the MatchUntilTerminator conditions, which
+    // are all looked for in a single pass over the buffer.
+    support::PatternScanner terminators;
+    // The static strings, and the condition each of them comes from.
+    support::PrefixTrie strings;
+    std::vector<std::size_t> string_conditions;
+    // The MatchUntilTerminator conditions, with the index of their
+    // terminator, and the EOFCondition ones.
+    std::vector<std::pair<std::size_t, std::size_t>> terminator_conditions;
+    std::vector<std::size_t> eof_conditions;
+  };
+  const Compiled compiled;
 
   using Arguments = std::tuple<>;
 
+  TransitionLookahead(Conditions c)
+      : conditions(std::move(c)), compiled(compile(conditions)) {}
+
   OperationResult operator()(InputOutputOperationContext &ctx,
                              const Arguments &) const;
   std::size_t handle_read(InputOutputOperationContext &ctx,
@@ -38,18 +79,25 @@ struct TransitionLookahead {
   void handle_eof(InputOutputOperationContext &ctx) const;
 
   // Returns true if the operation has enough data to produce a result.
-  // This lookahead is ready when any condition can be definitively matched or rejected.
+  // This lookahead is ready when any condition can be definitively matched or rejected,
+  // or when only one of them can still match.
   bool ready_to_evaluate(InputOutputOperationContext &ctx) const;
 
   std::string stringify() const;
 
 private:
-  static std::pair<bool, bool> match_condition(InputOutputOperationContext &ctx,
-                                               const EOFCondition &);
-  static std::pair<bool, bool> match_condition(InputOutputOperationContext &ctx,
-                                               const MatchUntilTerminator &c);
-  static std::pair<bool, bool> match_condition(InputOutputOperationContext &ctx,
-                                               const std::string &c);
+  static Compiled compile(const Conditions &conditions);
+
+  // Looks at the bytes of the input that were not seen yet, and
+  // records what they mean for the conditions in ctx.lookahead.
+  void advance(InputOutputOperationContext &ctx, std::string_view in) const;
+
+  struct Evaluation {
+    std::optional<int32_t> transition;
+    bool all_permanently_invalid;
+  };
+  Evaluation evaluate(InputOutputOperationContext &ctx) const;
+
   static std::string condition_to_string(const EOFCondition &);
   static std::string condition_to_string(const MatchUntilTerminator &c);
   static std::string condition_to_string(const std::string &c);
@@ -1,9 +1,11 @@
 #ifndef NETWORKPROTOCOLDSL_OPERATION_UNARYCALLBACK_HPP
 #define NETWORKPROTOCOLDSL_OPERATION_UNARYCALLBACK_HPP
 
+#include <networkprotocoldsl/callbackregistry.hpp>
 #include <networkprotocoldsl/operationconcepts.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -16,12 +18,15 @@ namespace operation {
 
 class UnaryCallback {
   const std::string key;
+  // resolved once, when the program is built.
+  const std::size_t id;
 
 public:
-  UnaryCallback(std::string c) : key(c) {}
+  UnaryCallback(std::string c) : key(c), id(CallbackRegistry::resolve(key)) {}
   using Arguments = std::tuple<Value>;
   OperationResult operator()(CallbackOperationContext &ctx, Arguments a) const;
   std::string callback_key(CallbackOperationContext &ctx) const;
+  std::size_t callback_id(CallbackOperationContext &ctx) const { return id; }
   void set_callback_return(CallbackOperationContext &ctx, Value v) const;
   void set_callback_called(CallbackOperationContext &ctx) const;
 
@@ -2,19 +2,20 @@
 #include <networkprotocoldsl/operationconcepts.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <algorithm>
 #include <cstring>
 
 namespace networkprotocoldsl::operation {
 
 static OperationResult _execute_operation(InputOutputOperationContext &ctx,
                                           value::Octets &oct) {
-  if (oct.data->length() == 0) {
+  if (oct.data.view().empty()) {
     return 0;
-  } else if (ctx.buffer.length() == 0) {
-    ctx.buffer = *(oct.data);
-    ctx.it = ctx.buffer.begin();
+  } else if (!ctx.output.has_value()) {
+    // the value's storage is shared, not copied.
+    ctx.output = oct;
   }
-  if (ctx.it != ctx.buffer.end()) {
+  if (ctx.written < ctx.output->data.view().size()) {
     if (ctx.eof) {
       return value::RuntimeError::ProtocolMismatchError;
     } else {
@@ -57,17 +58,24 @@ size_t WriteOctets::handle_read(InputOutputOperationContext &ctx,
 
 std::string_view
 WriteOctets::get_write_buffer(InputOutputOperationContext &ctx) const {
-  return std::string_view(ctx.it, ctx.buffer.end());
+  if (!ctx.output.has_value()) {
+    return {};
+  }
+  return ctx.output->data.view().substr(ctx.written);
+}
+
+value::Octets
+WriteOctets::get_write_octets(InputOutputOperationContext &ctx) const {
+  if (ctx.written == 0 && ctx.output.has_value()) {
+    return *ctx.output;
+  }
+  return value::Octets(std::string(get_write_buffer(ctx)));
 }
 
 size_t WriteOctets::handle_write(InputOutputOperationContext &ctx,
                                  size_t s) const {
-  size_t consumed = 0;
-  while (s > 0 && ctx.it != ctx.buffer.end()) {
-    s--;
-    consumed++;
-    ctx.it++;
-  }
+  size_t consumed = std::min(s, get_write_buffer(ctx).size());
+  ctx.written += consumed;
   return consumed;
 }
 
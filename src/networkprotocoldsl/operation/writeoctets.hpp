@@ -26,6 +26,7 @@ public:
                      std::string_view in) const;
 
   std::string_view get_write_buffer(InputOutputOperationContext &ctx) const;
+  value::Octets get_write_octets(InputOutputOperationContext &ctx) const;
   void handle_eof(InputOutputOperationContext &ctx) const;
 
   size_t handle_write(InputOutputOperationContext &ctx, size_t s) const;
@@ -36,7 +37,7 @@ public:
 
   std::string stringify() const { return "WriteOctets{}"; }
 };
-static_assert(InputOutputOperationConcept<WriteOctets>);
+static_assert(OctetsOutputOperationConcept<WriteOctets>);
 
 } // namespace operation
 
@@ -3,12 +3,13 @@
 #include <networkprotocoldsl/value.hpp>
 
 #include <cstring>
+#include <string_view>
 
 namespace networkprotocoldsl::operation {
 
 // Helper to perform escape replacement on a string.
 // Replaces occurrences of escape_char with escape_sequence in the output.
-static std::string apply_escape_replacement(const std::string &input,
+static std::string apply_escape_replacement(std::string_view input,
                                             const std::string &escape_char,
                                             const std::string &escape_sequence) {
   std::string result;
@@ -37,11 +38,11 @@ static OperationResult _execute_operation(InputOutputOperationContext &ctx,
                                           value::Octets &oct,
                                           const std::string &escape_char,
                                           const std::string &escape_sequence) {
-  if (oct.data->length() == 0) {
+  if (oct.data.view().empty()) {
     return 0;
   } else if (ctx.buffer.length() == 0) {
     // Apply escape replacement when first initializing the buffer
-    ctx.buffer = apply_escape_replacement(*(oct.data), escape_char, escape_sequence);
+    ctx.buffer = apply_escape_replacement(oct.data.view(), escape_char, escape_sequence);
     ctx.it = ctx.buffer.begin();
   }
   if (ctx.it != ctx.buffer.end()) {
@@ -2,17 +2,17 @@
 #include <networkprotocoldsl/operationconcepts.hpp>
 #include <networkprotocoldsl/value.hpp>
 
+#include <algorithm>
 #include <cstring>
 
 namespace networkprotocoldsl::operation {
 
 OperationResult WriteStaticOctets::operator()(InputOutputOperationContext &ctx,
                                               Arguments a) const {
-  if (ctx.buffer.length() == 0) {
-    ctx.buffer = contents;
-    ctx.it = ctx.buffer.begin();
+  if (!ctx.output.has_value()) {
+    ctx.output = contents;
   }
-  if (ctx.it != ctx.buffer.end()) {
+  if (ctx.written < ctx.output->data.view().size()) {
     if (ctx.eof) {
       return value::RuntimeError::ProtocolMismatchError;
     } else {
@@ -34,17 +34,24 @@ void WriteStaticOctets::handle_eof(InputOutputOperationContext &ctx) const {
 
 std::string_view
 WriteStaticOctets::get_write_buffer(InputOutputOperationContext &ctx) const {
-  return std::string_view(ctx.it, ctx.buffer.end());
+  if (!ctx.output.has_value()) {
+    return {};
+  }
+  return ctx.output->data.view().substr(ctx.written);
+}
+
+value::Octets
+WriteStaticOctets::get_write_octets(InputOutputOperationContext &ctx) const {
+  if (ctx.written == 0 && ctx.output.has_value()) {
+    return *ctx.output;
+  }
+  return value::Octets(std::string(get_write_buffer(ctx)));
 }
 
 size_t WriteStaticOctets::handle_write(InputOutputOperationContext &ctx,
                                        size_t s) const {
-  size_t consumed = 0;
-  while (s > 0 && ctx.it != ctx.buffer.end()) {
-    s--;
-    consumed++;
-    ctx.it++;
-  }
+  size_t consumed = std::min(s, get_write_buffer(ctx).size());
+  ctx.written += consumed;
   return consumed;
 }
 
@@ -16,11 +16,13 @@ namespace networkprotocoldsl {
 namespace operation {
 
 class WriteStaticOctets {
-  const std::string contents;
+  // shared with every write of it.
+  const value::Octets contents;
 
 public:
   using Arguments = std::tuple<>;
   WriteStaticOctets(const std::string &c) : contents(c) {}
+  const std::string &get_contents() const { return *contents.data; }
 
   OperationResult operator()(InputOutputOperationContext &ctx,
                              Arguments a) const;
@@ -28,6 +30,7 @@ public:
                      std::string_view in) const;
 
   std::string_view get_write_buffer(InputOutputOperationContext &ctx) const;
+  value::Octets get_write_octets(InputOutputOperationContext &ctx) const;
   void handle_eof(InputOutputOperationContext &ctx) const;
 
   size_t handle_write(InputOutputOperationContext &ctx, size_t s) const;
@@ -37,10 +40,10 @@ public:
   }
 
   std::string stringify() const {
-    return "WriteStaticOctets{contents: \"" + contents + "\"}";
+    return "WriteStaticOctets{contents: \"" + get_contents() + "\"}";
   }
 };
-static_assert(InputOutputOperationConcept<WriteStaticOctets>);
+static_assert(OctetsOutputOperationConcept<WriteStaticOctets>);
 
 } // namespace operation
 
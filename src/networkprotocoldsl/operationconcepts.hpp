@@ -5,9 +5,15 @@
 #include <networkprotocoldsl/value.hpp>
 
 #include <any>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
+#include <string>
 #include <tuple>
 #include <variant>
+#include <vector>
 
 namespace networkprotocoldsl {
 
@@ -44,11 +50,12 @@ concept OperationConcept = requires(OT op, typename OT::Arguments args) {
 };
 
 /**
- * Operations that take a dynamic number of arguments.
+ * Operations that take a dynamic number of arguments. The arguments
+ * are a view into the values accumulated by the interpreter.
  */
 template <typename OT>
 concept DynamicInputOperationConcept =
-    requires(OT op, std::shared_ptr<std::vector<Value>> args) {
+    requires(OT op, std::span<const Value> args) {
   { op(args) } -> std::convertible_to<Value>;
 };
 
@@ -80,11 +87,28 @@ concept CallbackOperationConcept = requires(OT op, typename OT::Arguments args,
                                             CallbackOperationContext ctx) {
   {OperationConcept<OT>};
   { op.callback_key(ctx) } -> std::convertible_to<std::string>;
+  { op.callback_id(ctx) } -> std::convertible_to<std::size_t>;
   { op(ctx, args) } -> std::convertible_to<OperationResult>;
   {op.set_callback_called(ctx)};
   {op.set_callback_return(ctx, v)};
 };
 
+/**
+ * What a lookahead learned about the input so far. The input it is
+ * shown always starts at the same byte and only grows, so each read
+ * only needs to look at the bytes that arrived since the previous one.
+ */
+struct LookaheadProgress {
+  // how many bytes of the input were looked at.
+  std::size_t seen = 0;
+  // where the input got in the trie of the static strings, and the
+  // first of them the input went past the end of, see PrefixTrie.
+  std::int32_t trie_state = 0;
+  std::size_t passed_string = static_cast<std::size_t>(-1);
+  // a bit per terminator that was found.
+  std::uint64_t terminators_found = 0;
+};
+
 /**
  * IO operations need additional context for accumulating the data
  * they need to execute.
@@ -92,8 +116,19 @@ concept CallbackOperationConcept = requires(OT op, typename OT::Arguments args,
 struct InputOutputOperationContext {
   std::string buffer;
   std::string::iterator it;
-  bool ready;
-  bool eof;
+  bool ready = false;
+  bool eof = false;
+  // The reference counted buffer the input points into, only set
+  // while handle_read runs. Reads may keep a slice of it in
+  // captured instead of copying the bytes into the buffer.
+  std::shared_ptr<const std::string> input;
+  std::optional<value::Octets> captured;
+  LookaheadProgress lookahead;
+  // What a write shares with the operation or the value it writes,
+  // instead of copying it into the buffer, and how much of it was
+  // written.
+  std::optional<value::Octets> output;
+  std::size_t written = 0;
 };
 
 /**
@@ -114,6 +149,18 @@ concept InputOutputOperationConcept = requires(OT op,
   {op.handle_eof(ctx)};
 };
 
+/**
+ * Writes that can hand what is left to write as Octets sharing the
+ * storage of what they write, so it can be queued for the connection
+ * without a copy. The bytes of other writes are copied.
+ */
+template <typename OT>
+concept OctetsOutputOperationConcept =
+    InputOutputOperationConcept<OT> &&
+    requires(OT op, InputOutputOperationContext ctx) {
+  { op.get_write_octets(ctx) } -> std::convertible_to<value::Octets>;
+};
+
 /**
  * Callback operations have a specific context type
  */
@@ -0,0 +1,258 @@
+#include <networkprotocoldsl/optimize.hpp>
+
+#include <networkprotocoldsl/operation.hpp>
+
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace networkprotocoldsl {
+
+using namespace operation;
+
+namespace {
+
+/**
+ * A node after optimization, along with the value it evaluates to
+ * when that can be known without running the program.
+ */
+struct OptimizedNode {
+  OpTreeNode node;
+  std::optional<Value> constant;
+};
+
+} // namespace
+
+static OptimizedNode optimize_node(const OpTreeNode &node);
+
+static std::shared_ptr<OpTree>
+optimize_optree(const std::shared_ptr<const OpTree> &optree) {
+  return std::make_shared<OpTree>(optimize_node(optree->root).node);
+}
+
+static std::vector<OpTreeNode>
+children_nodes(const std::vector<OptimizedNode> &children) {
+  std::vector<OpTreeNode> nodes;
+  nodes.reserve(children.size());
+  for (const auto &child : children) {
+    nodes.push_back(child.node);
+  }
+  return nodes;
+}
+
+template <typename O, std::size_t... I>
+static Value evaluate(const O &op, const std::vector<OptimizedNode> &children,
+                      std::index_sequence<I...>) {
+  return op(typename O::Arguments{*children[I].constant...});
+}
+
+/**
+ * Runs a pure operation when all of its arguments are known.
+ */
+template <typename O>
+static std::optional<Value>
+fold(const O &op, const std::vector<OptimizedNode> &children) {
+  constexpr std::size_t arity = std::tuple_size_v<typename O::Arguments>;
+  if (children.size() != arity) {
+    return std::nullopt;
+  }
+  for (const auto &child : children) {
+    if (!child.constant.has_value()) {
+      return std::nullopt;
+    }
+  }
+  Value v = evaluate(op, children, std::make_index_sequence<arity>());
+  // errors are left for the program to raise when it gets there.
+  if (std::holds_alternative<value::RuntimeError>(v) ||
+      std::holds_alternative<value::ControlFlowInstruction>(v)) {
+    return std::nullopt;
+  }
+  return v;
+}
+
+static OptimizedNode optimize_pure(const auto &op,
+                                   std::vector<OptimizedNode> &&children) {
+  auto constant = fold(op, children);
+  if (constant.has_value() && std::holds_alternative<int32_t>(*constant)) {
+    return {{Int32Literal(std::get<int32_t>(*constant)), {}}, constant};
+  }
+  // there are no literals for the other types, but the operation
+  // consuming the value may still make use of it.
+  return {{op, children_nodes(children)}, constant};
+}
+
+static OptimizedNode optimize_operation(const Int32Literal &op,
+                                        std::vector<OptimizedNode> &&) {
+  return {{op, {}}, op({})};
+}
+
+static OptimizedNode optimize_operation(const Add &op,
+                                        std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode
+optimize_operation(const Subtract &op, std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode
+optimize_operation(const Multiply &op, std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode optimize_operation(const Eq &op,
+                                        std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode
+optimize_operation(const LesserEqual &op,
+                   std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode
+optimize_operation(const IntToAscii &op,
+                   std::vector<OptimizedNode> &&children) {
+  return optimize_pure(op, std::move(children));
+}
+
+static OptimizedNode
+optimize_operation(const WriteOctets &op,
+                   std::vector<OptimizedNode> &&children) {
+  if (children.size() == 1 && children[0].constant.has_value()) {
+    if (const auto *octets =
+            std::get_if<value::Octets>(&*children[0].constant)) {
+      return {{WriteStaticOctets(*octets->data), {}}, std::nullopt};
+    }
+  }
+  return {{op, children_nodes(children)}, std::nullopt};
+}
+
+/**
+ * If evaluates both branches before choosing one, but the branches
+ * are static callables, so when the condition is known the other one
+ * can go away, and so can the If itself.
+ */
+static OptimizedNode optimize_operation(const If &op,
+                                        std::vector<OptimizedNode> &&children) {
+  if (children.size() == 3 && children[0].constant.has_value() &&
+      std::holds_alternative<bool>(*children[0].constant) &&
+      std::holds_alternative<StaticCallable>(children[1].node.operation) &&
+      std::holds_alternative<StaticCallable>(children[2].node.operation)) {
+    const auto &branch =
+        std::get<bool>(*children[0].constant) ? children[1] : children[2];
+    return {{FunctionCall{}, {branch.node, {DynamicList{}, {}}}},
+            std::nullopt};
+  }
+  return {{op, children_nodes(children)}, std::nullopt};
+}
+
+static void append_to_sequence(std::vector<OpTreeNode> &sequence,
+                               const OpTreeNode &node) {
+  if (!sequence.empty()) {
+    const auto *previous =
+        std::get_if<WriteStaticOctets>(&sequence.back().operation);
+    const auto *next = std::get_if<WriteStaticOctets>(&node.operation);
+    if (previous && next) {
+      OpTreeNode merged{
+          WriteStaticOctets(previous->get_contents() + next->get_contents()),
+          {}};
+      sequence.pop_back();
+      sequence.push_back(merged);
+      return;
+    }
+  }
+  sequence.push_back(node);
+}
+
+/**
+ * The value of a sequence is the value of its last element, so a
+ * nested sequence can be spliced into its parent, and elements with
+ * a known value can be dropped unless they are the last one.
+ */
+static OptimizedNode
+optimize_operation(const OpSequence &op,
+                   std::vector<OptimizedNode> &&children) {
+  if (children.size() == 1) {
+    return std::move(children[0]);
+  }
+  std::vector<OpTreeNode> sequence;
+  for (std::size_t i = 0; i < children.size(); i++) {
+    const auto &child = children[i];
+    if (child.constant.has_value() && i + 1 < children.size()) {
+      continue;
+    }
+    if (std::holds_alternative<OpSequence>(child.node.operation) &&
+        !child.node.children.empty()) {
+      for (const auto &grandchild : child.node.children) {
+        append_to_sequence(sequence, grandchild);
+      }
+    } else {
+      append_to_sequence(sequence, child.node);
+    }
+  }
+  if (sequence.size() == 1) {
+    return {sequence[0], std::nullopt};
+  }
+  return {{op, sequence}, std::nullopt};
+}
+
+static OptimizedNode
+optimize_operation(const StaticCallable &op,
+                   std::vector<OptimizedNode> &&children) {
+  return {{StaticCallable(optimize_optree(op.get_optree()),
+                          op.get_argument_names(),
+                          op.get_inherits_lexical_pad()),
+           children_nodes(children)},
+          std::nullopt};
+}
+
+static OptimizedNode
+optimize_operation(const StateMachineOperation &op,
+                   std::vector<OptimizedNode> &&children) {
+  // the pad layouts are kept, the optimized trees introduce the same
+  // variables in the same order.
+  StateMachineOperation::StateMap states = op.get_states();
+  for (auto &[state_name, state] : states) {
+    if (state.callback_optree) {
+      state.callback_optree = optimize_optree(state.callback_optree);
+    }
+    for (auto &[transition_name, transition] : state.transitions) {
+      if (transition.callback_optree) {
+        transition.callback_optree =
+            optimize_optree(transition.callback_optree);
+      }
+    }
+  }
+  return {{StateMachineOperation(std::move(states)),
+           children_nodes(children)},
+          std::nullopt};
+}
+
+static OptimizedNode optimize_operation(const auto &op,
+                                        std::vector<OptimizedNode> &&children) {
+  return {{op, children_nodes(children)}, std::nullopt};
+}
+
+static OptimizedNode optimize_node(const OpTreeNode &node) {
+  std::vector<OptimizedNode> children;
+  children.reserve(node.children.size());
+  for (const auto &child : node.children) {
+    children.push_back(optimize_node(child));
+  }
+  return std::visit(
+      [&](const auto &op) {
+        return optimize_operation(op, std::move(children));
+      },
+      node.operation);
+}
+
+std::shared_ptr<const OpTree> optimize(const std::shared_ptr<const OpTree> &o) {
+  return optimize_optree(o);
+}
+
+} // namespace networkprotocoldsl
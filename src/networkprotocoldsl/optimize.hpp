@@ -0,0 +1,28 @@
+#ifndef NETWORKPROTOCOLDSL_OPTIMIZE_HPP
+#define NETWORKPROTOCOLDSL_OPTIMIZE_HPP
+
+#include <networkprotocoldsl/optree.hpp>
+
+#include <memory>
+
+namespace networkprotocoldsl {
+
+/**
+ * Rewrites a generated program into an equivalent one that takes
+ * fewer steps to run.
+ *
+ * Pure operations over literals are evaluated ahead of time, an If
+ * with a known condition only keeps the branch it would take, nested
+ * OpSequence nodes are flattened into their parent and consecutive
+ * WriteStaticOctets are merged into a single write. The trees of the
+ * callables and of the state machine callbacks are optimized as well.
+ *
+ * The order in which the lexical pad variables are introduced is
+ * preserved, so operations already resolved to pad slots remain
+ * valid.
+ */
+std::shared_ptr<const OpTree> optimize(const std::shared_ptr<const OpTree> &o);
+
+} // namespace networkprotocoldsl
+
+#endif // NETWORKPROTOCOLDSL_OPTIMIZE_HPP
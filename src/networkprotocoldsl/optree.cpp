@@ -1 +1,103 @@
 #include <networkprotocoldsl/optree.hpp>
+
+#include <networkprotocoldsl/continuation.hpp>
+#include <networkprotocoldsl/executionstackframe.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace networkprotocoldsl {
+
+static OpTreeInstruction make_instruction(const OpTreeNode &node) {
+  return {&node.operation,
+          &node,
+          0,
+          0,
+          &FrameHooks::for_operation(node.operation),
+          &ContinuationHooks::for_operation(node.operation)};
+}
+
+/**
+ * Lay the tree out breadth-first, which keeps the children of every
+ * node next to each other in the resulting array.
+ */
+static std::vector<OpTreeInstruction> lower(const OpTreeNode &root) {
+  std::vector<OpTreeInstruction> instructions;
+  instructions.push_back(make_instruction(root));
+  for (std::size_t i = 0; i < instructions.size(); i++) {
+    const OpTreeNode *node = instructions[i].node;
+    instructions[i].first_child = instructions.size();
+    instructions[i].children_count = node->children.size();
+    for (const auto &child : node->children) {
+      instructions.push_back(make_instruction(child));
+    }
+  }
+  return instructions;
+}
+
+/**
+ * Children always come after their parent, so walking the array
+ * backwards visits every child before the node that owns it.
+ */
+static std::pair<std::size_t, std::size_t>
+measure(const std::vector<OpTreeInstruction> &instructions) {
+  std::vector<std::size_t> depth(instructions.size(), 1);
+  std::vector<std::size_t> registers(instructions.size(), 0);
+  for (std::size_t i = instructions.size(); i > 0; i--) {
+    const OpTreeInstruction &ins = instructions[i - 1];
+    std::size_t child_depth = 0;
+    std::size_t child_registers = 0;
+    for (std::size_t c = 0; c < ins.children_count; c++) {
+      child_depth = std::max(child_depth, depth[ins.first_child + c]);
+      child_registers =
+          std::max(child_registers, registers[ins.first_child + c]);
+    }
+    depth[i - 1] = child_depth + 1;
+    registers[i - 1] = ins.children_count + child_registers;
+  }
+  return {depth[0], registers[0]};
+}
+
+/**
+ * The locals are listed in the order they appear in the tree, which
+ * does not change when the tree is rewritten by the optimizer.
+ */
+static void collect_pad_locals(const OpTreeNode &node,
+                               std::vector<std::string> &locals) {
+  if (const auto *init =
+          std::get_if<operation::LexicalPadInitialize>(&node.operation)) {
+    if (std::find(locals.begin(), locals.end(), init->get_name()) ==
+        locals.end()) {
+      locals.push_back(init->get_name());
+    }
+  }
+  for (const auto &child : node.children) {
+    collect_pad_locals(child, locals);
+  }
+}
+
+static std::vector<std::string> collect_pad_locals(const OpTreeNode &root) {
+  std::vector<std::string> locals;
+  collect_pad_locals(root, locals);
+  return locals;
+}
+
+OpTree::OpTree(const OpTreeNode r)
+    : root(r), instructions(lower(root)),
+      pad_locals(collect_pad_locals(root)) {
+  std::tie(max_depth, max_registers) = measure(instructions);
+}
+
+std::shared_ptr<const LexicalPadLayout>
+OpTree::pad_layout(const std::vector<std::string> &argument_names) const {
+  auto layout = std::make_shared<LexicalPadLayout>(argument_names);
+  for (const auto &name : pad_locals) {
+    if (std::find(argument_names.begin(), argument_names.end(), name) ==
+        argument_names.end()) {
+      layout->push_back(name);
+    }
+  }
+  return layout;
+}
+
+} // namespace networkprotocoldsl
@@ -3,11 +3,17 @@
 
 #include <networkprotocoldsl/operation.hpp>
 
+#include <cstddef>
+#include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace networkprotocoldsl {
 
+struct FrameHooks;
+struct ContinuationHooks;
+
 /**
  * A node in the operation tree.
  */
@@ -16,12 +22,52 @@ struct OpTreeNode {
   const std::vector<OpTreeNode> children;
 };
 
+/**
+ * An entry in the lowered form of the operation tree. The children
+ * of an instruction are stored contiguously in the instruction
+ * array, starting at first_child, so the interpreter can walk the
+ * program by index instead of recursing through the tree.
+ */
+struct OpTreeInstruction {
+  const Operation *operation;
+  const OpTreeNode *node;
+  std::size_t first_child;
+  std::size_t children_count;
+  // how the frames and continuations run this operation, resolved
+  // from its type when the tree is lowered.
+  const FrameHooks *frame_hooks;
+  const ContinuationHooks *continuation_hooks;
+};
+
 /**
  * The immutable representation
+ *
+ * The tree is lowered into a flat instruction array at construction
+ * time, the root is always the first instruction. Since the
+ * instructions point into the tree, copying the OpTree lowers it
+ * again.
  */
 struct OpTree {
   const OpTreeNode root;
-  OpTree(const OpTreeNode r) : root(r){};
+  const std::vector<OpTreeInstruction> instructions;
+  // The deepest chain of nested operations, used to size the frame stack.
+  std::size_t max_depth;
+  // Upper bound on the values accumulated at once by a chain of frames.
+  std::size_t max_registers;
+  // Names introduced by LexicalPadInitialize in this tree, not
+  // counting the trees of nested callables.
+  std::vector<std::string> pad_locals;
+
+  OpTree(const OpTreeNode r);
+  OpTree(const OpTree &other) : OpTree(other.root){};
+
+  /**
+   * The slots of a pad created to run this tree with the given
+   * argument names: the arguments first, in order, followed by the
+   * locals that are not also arguments.
+   */
+  std::shared_ptr<const LexicalPadLayout>
+  pad_layout(const std::vector<std::string> &argument_names) const;
 };
 
 } // namespace networkprotocoldsl
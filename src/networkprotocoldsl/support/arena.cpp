@@ -0,0 +1,75 @@
+#include <networkprotocoldsl/support/arena.hpp>
+
+#include <cassert>
+#include <new>
+#include <optional>
+
+namespace networkprotocoldsl::support {
+
+static std::optional<std::size_t>
+size_class(std::size_t bytes, std::size_t alignment, std::size_t min_block,
+           std::size_t classes) {
+  if (alignment > min_block) {
+    return std::nullopt;
+  }
+  std::size_t block = min_block;
+  for (std::size_t n = 0; n < classes; n++) {
+    if (bytes <= block) {
+      return n;
+    }
+    block <<= 1;
+  }
+  return std::nullopt;
+}
+
+void *Arena::bump(std::size_t size) {
+  if (current_chunk < chunks.size() && offset + size > chunk_size) {
+    current_chunk++;
+    offset = 0;
+  }
+  if (current_chunk == chunks.size()) {
+    chunks.push_back(std::make_unique<std::byte[]>(chunk_size));
+    offset = 0;
+  }
+  void *p = chunks[current_chunk].get() + offset;
+  offset += size;
+  return p;
+}
+
+void *Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  auto c = size_class(bytes, alignment, min_block_size, size_classes);
+  if (!c.has_value()) {
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  live_allocations++;
+  FreeBlock *block = free_lists[*c];
+  if (block) {
+    free_lists[*c] = block->next;
+    return block;
+  }
+  return bump(min_block_size << *c);
+}
+
+void Arena::do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+  auto c = size_class(bytes, alignment, min_block_size, size_classes);
+  if (!c.has_value()) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    return;
+  }
+  live_allocations--;
+  free_lists[*c] = new (p) FreeBlock{free_lists[*c]};
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource &other) const
+    noexcept {
+  return this == &other;
+}
+
+void Arena::reset() {
+  assert(live_allocations == 0);
+  free_lists.fill(nullptr);
+  current_chunk = 0;
+  offset = 0;
+}
+
+} // namespace networkprotocoldsl::support
@@ -0,0 +1,79 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_ARENA_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_ARENA_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * A memory resource for the short-lived bookkeeping of a single
+ * interpreter: continuations, their frames and registers, and the
+ * lexical pads of the callables being run.
+ *
+ * Memory is carved out of large chunks with a bump pointer. Released
+ * blocks go to a free list for their size class, so the same blocks
+ * are handed out again when the next callable is invoked. Chunks are
+ * only returned to the system when the arena is destroyed, which
+ * means an interpreter in steady state does not call malloc for any
+ * of those objects.
+ *
+ * The arena is not thread safe. It belongs to an interpreter, and an
+ * interpreter is only ever stepped by one thread at a time.
+ */
+class Arena : public std::pmr::memory_resource {
+  static constexpr std::size_t chunk_size = 64 * 1024;
+  static constexpr std::size_t min_block_size = alignof(std::max_align_t);
+  // blocks of min_block_size << n, for n up to size_classes - 1. Larger
+  // requests go directly to the upstream allocator.
+  static constexpr std::size_t size_classes = 12;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  std::vector<std::unique_ptr<std::byte[]>> chunks;
+  std::size_t current_chunk = 0;
+  std::size_t offset = 0;
+  std::array<FreeBlock *, size_classes> free_lists{};
+  std::size_t live_allocations = 0;
+
+  void *bump(std::size_t size);
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override;
+
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena(Arena &&) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * Forgets about every block handed out so far and starts carving
+   * from the first chunk again, keeping the chunks. Must only be
+   * called when nothing allocated from the arena is alive anymore.
+   */
+  void reset();
+
+  /**
+   * Number of blocks currently handed out.
+   */
+  std::size_t in_use() const { return live_allocations; }
+
+  /**
+   * Number of chunks obtained from the system so far.
+   */
+  std::size_t chunk_count() const { return chunks.size(); }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
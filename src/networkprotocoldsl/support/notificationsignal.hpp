@@ -1,10 +1,10 @@
 #ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_NOTIFICATIONSIGNAL_HPP
 #define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_NOTIFICATIONSIGNAL_HPP
 
-#include <condition_variable>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
-#include <mutex>
-
+#include <string>
 #include <thread>
 
 #define NOTIFICATIONSIGNAL_DEBUG(x)
@@ -14,44 +14,81 @@
 
 namespace networkprotocoldsl::support {
 
+/**
+ * Wakes up the threads waiting for something to happen.
+ *
+ * The signal is a generation counter that notify() bumps. Waiting
+ * threads sleep on the counter itself with std::atomic::wait, which is
+ * a futex on Linux, and notify() only makes the system call to wake
+ * them when somebody is registered as waiting. Most notifications
+ * happen while the other threads are busy, so they cost no more than
+ * a couple of atomic operations.
+ */
 class NotificationSignal {
   std::string name;
-  std::mutex mtx;
-  std::condition_variable cv;
   std::atomic<bool> notified = false;
+  // 32 bits, the size of a futex.
+  std::atomic<std::uint32_t> generation = 0;
+  std::atomic<std::uint32_t> waiters = 0;
 
 public:
-  NotificationSignal(const std::string &n)
-      : name(n), mtx(std::mutex()), cv(std::condition_variable()) {}
+  NotificationSignal(const std::string &n) : name(n) {}
   NotificationSignal(const NotificationSignal &in) = delete;
   NotificationSignal(NotificationSignal &&in) = delete;
   NotificationSignal &operator=(const NotificationSignal &) = delete;
 
   void notify() {
-    {
-      NOTIFICATIONSIGNAL_DEBUG("before guard");
-      std::lock_guard<std::mutex> lk(mtx);
-      NOTIFICATIONSIGNAL_DEBUG("after guard");
-      notified.store(true);
+    notified.store(true);
+    // Either a waiter registered before this and gets woken up, or it
+    // registers after and sees the new generation before sleeping.
+    generation.fetch_add(1);
+    if (waiters.load() > 0) {
+      NOTIFICATIONSIGNAL_DEBUG("waking up waiters");
+      generation.notify_all();
+    }
+  }
+
+  /**
+   * Like notify(), but wakes up only one of the waiters, for when any
+   * of them can take care of what happened.
+   */
+  void notify_one() {
+    notified.store(true);
+    generation.fetch_add(1);
+    if (waiters.load() > 0) {
+      NOTIFICATIONSIGNAL_DEBUG("waking up one waiter");
+      generation.notify_one();
     }
-    NOTIFICATIONSIGNAL_DEBUG("before notify");
-    cv.notify_all();
-    NOTIFICATIONSIGNAL_DEBUG("after notify");
   }
 
   void wait() {
-    NOTIFICATIONSIGNAL_DEBUG("before lock");
-    std::unique_lock<std::mutex> lk(mtx);
-    NOTIFICATIONSIGNAL_DEBUG("after lock");
+    std::uint32_t seen = generation.load();
     if (!notified.load()) {
       NOTIFICATIONSIGNAL_DEBUG("not notified, before wait");
-      cv.wait(lk);
+      wait_for_generation_change(seen);
       NOTIFICATIONSIGNAL_DEBUG("not notified, after wait");
     } else {
       NOTIFICATIONSIGNAL_DEBUG("no wait");
     }
     notified.store(false);
   }
+
+  /**
+   * wait() is meant for a single waiter, since the first one to wake
+   * up clears the notification for everybody else. When several
+   * threads wait on the same signal, each of them takes note of the
+   * generation before looking for work, and then waits for it to
+   * change, which can't miss a notification that came in between.
+   */
+  std::uint32_t current_generation() { return generation.load(); }
+
+  void wait_for_generation_change(std::uint32_t seen) {
+    waiters.fetch_add(1);
+    while (generation.load() == seen) {
+      generation.wait(seen);
+    }
+    waiters.fetch_sub(1);
+  }
 };
 
 } // namespace networkprotocoldsl::support
@@ -0,0 +1,224 @@
+#include <networkprotocoldsl/support/patternscanner.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PATTERNSCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace networkprotocoldsl::support {
+
+bool PatternScanner::supported(Implementation implementation) {
+  switch (implementation) {
+  case Implementation::Scalar:
+    return true;
+#ifdef PATTERNSCANNER_X86
+  case Implementation::SSE2:
+    return __builtin_cpu_supports("sse2");
+  case Implementation::AVX2:
+    return __builtin_cpu_supports("avx2");
+#else
+  case Implementation::SSE2:
+  case Implementation::AVX2:
+    return false;
+#endif
+  }
+  return false;
+}
+
+PatternScanner::Implementation PatternScanner::best_implementation() {
+  static const Implementation best = [] {
+    if (supported(Implementation::AVX2)) {
+      return Implementation::AVX2;
+    }
+    if (supported(Implementation::SSE2)) {
+      return Implementation::SSE2;
+    }
+    return Implementation::Scalar;
+  }();
+  return best;
+}
+
+PatternScanner::PatternScanner(std::vector<std::string> p, Implementation i)
+    : patterns(std::move(p)), implementation(i) {
+  if (patterns.size() > max_patterns) {
+    throw std::invalid_argument("PatternScanner: too many patterns");
+  }
+  for (const auto &pattern : patterns) {
+    if (pattern.empty()) {
+      throw std::invalid_argument("PatternScanner: empty pattern");
+    }
+    longest = std::max(longest, pattern.size());
+    unsigned char first = pattern[0];
+    if (!is_first_byte[first]) {
+      is_first_byte[first] = true;
+      first_bytes.push_back(pattern[0]);
+    }
+  }
+  if (!supported(implementation)) {
+    implementation = best_implementation();
+  }
+  // the vector loops assume there is at least one pattern to compare
+  // against, and would read past the end of the input otherwise.
+  if (patterns.empty() || patterns.size() > max_vector_patterns) {
+    implementation = Implementation::Scalar;
+  }
+}
+
+PatternScanner::Match PatternScanner::match_at(std::string_view in,
+                                               std::size_t position) const {
+  std::string_view rest = in.substr(position);
+  for (std::size_t p = 0; p < patterns.size(); p++) {
+    if (rest.starts_with(patterns[p])) {
+      return {position, p};
+    }
+  }
+  return {};
+}
+
+PatternScanner::Match PatternScanner::find_scalar(std::string_view in,
+                                                  std::size_t from) const {
+  for (std::size_t i = from; i < in.size(); i++) {
+    if (first_bytes.size() == 1) {
+      const void *found =
+          std::memchr(in.data() + i, first_bytes[0], in.size() - i);
+      if (!found) {
+        break;
+      }
+      i = static_cast<const char *>(found) - in.data();
+    } else if (!is_first_byte[static_cast<unsigned char>(in[i])]) {
+      continue;
+    }
+    if (auto m = match_at(in, i); m.position != npos) {
+      return m;
+    }
+  }
+  return {};
+}
+
+#ifdef PATTERNSCANNER_X86
+
+// Every position in the block where the first and the last byte of a
+// pattern are where they would be, in the manner of the generic SIMD
+// substring search: comparing two bytes that far apart weeds out
+// almost every place the first byte alone would have matched.
+
+__attribute__((target("sse2"))) PatternScanner::Match
+PatternScanner::find_sse2(std::string_view in, std::size_t from) const {
+  const std::size_t count = patterns.size();
+  __m128i first[max_vector_patterns];
+  __m128i last[max_vector_patterns];
+  std::size_t last_offset[max_vector_patterns];
+  for (std::size_t p = 0; p < count; p++) {
+    first[p] = _mm_set1_epi8(patterns[p].front());
+    last[p] = _mm_set1_epi8(patterns[p].back());
+    last_offset[p] = patterns[p].size() - 1;
+  }
+  const char *data = in.data();
+  std::size_t i = from;
+  for (; i + longest - 1 + 16 <= in.size(); i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    unsigned mask = 0;
+    for (std::size_t p = 0; p < count; p++) {
+      __m128i ends = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(data + i + last_offset[p]));
+      __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(block, first[p]),
+                                   _mm_cmpeq_epi8(ends, last[p]));
+      mask |= static_cast<unsigned>(_mm_movemask_epi8(hits));
+    }
+    for (; mask != 0; mask &= mask - 1) {
+      if (auto m = match_at(in, i + __builtin_ctz(mask)); m.position != npos) {
+        return m;
+      }
+    }
+  }
+  return find_scalar(in, i);
+}
+
+__attribute__((target("avx2"))) PatternScanner::Match
+PatternScanner::find_avx2(std::string_view in, std::size_t from) const {
+  const std::size_t count = patterns.size();
+  __m256i first[max_vector_patterns];
+  __m256i last[max_vector_patterns];
+  std::size_t last_offset[max_vector_patterns];
+  for (std::size_t p = 0; p < count; p++) {
+    first[p] = _mm256_set1_epi8(patterns[p].front());
+    last[p] = _mm256_set1_epi8(patterns[p].back());
+    last_offset[p] = patterns[p].size() - 1;
+  }
+  const char *data = in.data();
+  std::size_t i = from;
+  for (; i + longest - 1 + 32 <= in.size(); i += 32) {
+    __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    unsigned mask = 0;
+    for (std::size_t p = 0; p < count; p++) {
+      __m256i ends = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(data + i + last_offset[p]));
+      __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(block, first[p]),
+                                      _mm256_cmpeq_epi8(ends, last[p]));
+      mask |= static_cast<unsigned>(_mm256_movemask_epi8(hits));
+    }
+    for (; mask != 0; mask &= mask - 1) {
+      if (auto m = match_at(in, i + __builtin_ctz(mask)); m.position != npos) {
+        return m;
+      }
+    }
+  }
+  // what is left is shorter than a block of 32, but may fit one of 16.
+  return find_sse2(in, i);
+}
+
+#else
+
+PatternScanner::Match PatternScanner::find_sse2(std::string_view in,
+                                                std::size_t from) const {
+  return find_scalar(in, from);
+}
+
+PatternScanner::Match PatternScanner::find_avx2(std::string_view in,
+                                                std::size_t from) const {
+  return find_scalar(in, from);
+}
+
+#endif
+
+PatternScanner::Match PatternScanner::find(std::string_view in,
+                                           std::size_t from) const {
+  if (from >= in.size() || patterns.empty()) {
+    return {};
+  }
+  switch (implementation) {
+  case Implementation::AVX2:
+    return find_avx2(in, from);
+  case Implementation::SSE2:
+    return find_sse2(in, from);
+  case Implementation::Scalar:
+    break;
+  }
+  return find_scalar(in, from);
+}
+
+std::uint64_t PatternScanner::occurring(std::string_view in) const {
+  std::uint64_t all = patterns.size() == max_patterns
+                          ? ~std::uint64_t(0)
+                          : (std::uint64_t(1) << patterns.size()) - 1;
+  std::uint64_t seen = 0;
+  for (Match m = find(in, 0); m.position != npos && seen != all;
+       m = find(in, m.position + 1)) {
+    // find only reports the first of the patterns starting there.
+    std::string_view rest = in.substr(m.position);
+    for (std::size_t p = m.pattern; p < patterns.size(); p++) {
+      if (rest.starts_with(patterns[p])) {
+        seen |= std::uint64_t(1) << p;
+      }
+    }
+  }
+  return seen;
+}
+
+} // namespace networkprotocoldsl::support
@@ -0,0 +1,92 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PATTERNSCANNER_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PATTERNSCANNER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * Finds the earliest occurrence of any of a few short byte patterns,
+ * such as a terminator and an escape sequence, in a single pass over
+ * the input.
+ *
+ * With SSE2 or AVX2, a block of the input is compared at once against
+ * the first and the last byte of every pattern, and a pattern is only
+ * compared in full where both of them are in place, which in text
+ * made of CRLF terminated lines is rarely anywhere but where it
+ * matches. Without them, or with more patterns than fit that scheme,
+ * the patterns are compared wherever one of the bytes they start with
+ * is found. Which instructions to use is decided once, at run time.
+ *
+ * Immutable once built, so it can be shared by any number of threads.
+ */
+class PatternScanner {
+public:
+  enum class Implementation { Scalar, SSE2, AVX2 };
+
+  static constexpr std::size_t npos = std::string_view::npos;
+  // occurring() reports each pattern as a bit.
+  static constexpr std::size_t max_patterns = 64;
+  // more patterns than this are scanned for with the scalar loop.
+  static constexpr std::size_t max_vector_patterns = 8;
+
+  struct Match {
+    // npos when none of the patterns was found.
+    std::size_t position = npos;
+    std::size_t pattern = npos;
+  };
+
+private:
+  std::vector<std::string> patterns;
+  // the distinct bytes the patterns start with, and the same as a
+  // table, for the scalar loop.
+  std::string first_bytes;
+  std::array<bool, 256> is_first_byte{};
+  std::size_t longest = 0;
+  Implementation implementation;
+
+  Match find_scalar(std::string_view in, std::size_t from) const;
+  Match find_sse2(std::string_view in, std::size_t from) const;
+  Match find_avx2(std::string_view in, std::size_t from) const;
+  Match match_at(std::string_view in, std::size_t position) const;
+
+public:
+  /**
+   * The patterns must not be empty, and there can be at most
+   * max_patterns of them. An empty list never matches. An
+   * implementation the processor doesn't support is replaced by the
+   * best one it does.
+   */
+  explicit PatternScanner(std::vector<std::string> patterns,
+                          Implementation implementation =
+                              best_implementation());
+
+  static bool supported(Implementation implementation);
+  static Implementation best_implementation();
+
+  /**
+   * The earliest position, at or after from, where one of the
+   * patterns starts and fits entirely in the input. When several
+   * patterns start there, the one listed first wins.
+   */
+  Match find(std::string_view in, std::size_t from = 0) const;
+
+  /**
+   * Which of the patterns appear anywhere in the input, as a bit per
+   * pattern. Stops looking as soon as all of them were seen.
+   */
+  std::uint64_t occurring(std::string_view in) const;
+
+  const std::vector<std::string> &get_patterns() const { return patterns; }
+  std::size_t longest_pattern() const { return longest; }
+  Implementation get_implementation() const { return implementation; }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
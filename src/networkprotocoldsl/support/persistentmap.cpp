@@ -0,0 +1 @@
+#include <networkprotocoldsl/support/persistentmap.hpp>
@@ -0,0 +1,310 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PERSISTENTMAP_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PERSISTENTMAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * An immutable hash map where adding or removing a key makes a new map
+ * that shares everything but the path to that key with the old one.
+ *
+ * This is a hash array mapped trie: every branch takes 5 bits of the
+ * hash to pick one of up to 32 children, and stores only the children
+ * that are there. Leaves hold the entries whose hashes are the same.
+ * Changing a map copies at most one branch per level, so it costs
+ * O(log N) instead of copying the whole map, while readers can keep
+ * using the old map for as long as they hold on to it.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class PersistentMap {
+public:
+  using value_type = std::pair<const Key, Value>;
+
+private:
+  static constexpr unsigned bits_per_level = 5;
+  static constexpr std::size_t hash_bits = sizeof(std::size_t) * 8;
+
+  struct Node {
+    // Branches have a bitmap of the children they hold, in order.
+    uint32_t bitmap = 0;
+    std::vector<std::shared_ptr<const Node>> children;
+    // Leaves have the entries with this hash.
+    std::size_t hash = 0;
+    std::vector<value_type> entries;
+
+    bool is_leaf() const { return !entries.empty(); }
+  };
+  using NodePtr = std::shared_ptr<const Node>;
+
+  NodePtr root;
+  std::size_t count = 0;
+
+  PersistentMap(NodePtr root, std::size_t count)
+      : root(std::move(root)), count(count) {}
+
+  static std::size_t slot(std::size_t hash, unsigned shift) {
+    return shift < hash_bits ? (hash >> shift) & 31 : 0;
+  }
+
+  static std::size_t position(uint32_t bitmap, uint32_t bit) {
+    return std::popcount(bitmap & (bit - 1));
+  }
+
+  static NodePtr make_leaf(std::size_t hash, value_type entry) {
+    auto leaf = std::make_shared<Node>();
+    leaf->hash = hash;
+    leaf->entries.push_back(std::move(entry));
+    return leaf;
+  }
+
+  static NodePtr insert(const NodePtr &node, std::size_t hash, unsigned shift,
+                        value_type &entry, bool &added) {
+    if (!node) {
+      added = true;
+      return make_leaf(hash, std::move(entry));
+    }
+    if (node->is_leaf()) {
+      if (node->hash == hash) {
+        auto leaf = std::make_shared<Node>(*node);
+        for (auto &existing : leaf->entries) {
+          if (existing.first == entry.first) {
+            existing.second = std::move(entry.second);
+            return leaf;
+          }
+        }
+        added = true;
+        leaf->entries.push_back(std::move(entry));
+        return leaf;
+      }
+      // the hashes differ, so they part ways somewhere below here.
+      auto branch = std::make_shared<Node>();
+      branch->bitmap = uint32_t(1) << slot(node->hash, shift);
+      branch->children.push_back(node);
+      return insert(branch, hash, shift, entry, added);
+    }
+    uint32_t bit = uint32_t(1) << slot(hash, shift);
+    std::size_t pos = position(node->bitmap, bit);
+    auto branch = std::make_shared<Node>(*node);
+    if (node->bitmap & bit) {
+      branch->children[pos] = insert(node->children[pos], hash,
+                                     shift + bits_per_level, entry, added);
+    } else {
+      added = true;
+      branch->bitmap |= bit;
+      branch->children.insert(branch->children.begin() + pos,
+                              make_leaf(hash, std::move(entry)));
+    }
+    return branch;
+  }
+
+  static NodePtr erase(const NodePtr &node, std::size_t hash, unsigned shift,
+                       const Key &key, bool &removed) {
+    if (!node) {
+      return node;
+    }
+    if (node->is_leaf()) {
+      if (node->hash != hash) {
+        return node;
+      }
+      for (std::size_t i = 0; i < node->entries.size(); i++) {
+        if (node->entries[i].first == key) {
+          removed = true;
+          if (node->entries.size() == 1) {
+            return nullptr;
+          }
+          // the keys are const, so the entries cannot be moved around.
+          auto leaf = std::make_shared<Node>();
+          leaf->hash = hash;
+          for (std::size_t j = 0; j < node->entries.size(); j++) {
+            if (j != i) {
+              leaf->entries.push_back(node->entries[j]);
+            }
+          }
+          return leaf;
+        }
+      }
+      return node;
+    }
+    uint32_t bit = uint32_t(1) << slot(hash, shift);
+    if (!(node->bitmap & bit)) {
+      return node;
+    }
+    std::size_t pos = position(node->bitmap, bit);
+    NodePtr child = erase(node->children[pos], hash, shift + bits_per_level,
+                          key, removed);
+    if (!removed) {
+      return node;
+    }
+    if (!child) {
+      if (node->children.size() == 1) {
+        return nullptr;
+      }
+      if (node->children.size() == 2 && node->children[1 - pos]->is_leaf()) {
+        // a leaf can sit at any depth, so the branch is not needed.
+        return node->children[1 - pos];
+      }
+    } else if (child->is_leaf() && node->children.size() == 1) {
+      return child;
+    }
+    auto branch = std::make_shared<Node>(*node);
+    if (child) {
+      branch->children[pos] = child;
+    } else {
+      branch->bitmap &= ~bit;
+      branch->children.erase(branch->children.begin() + pos);
+    }
+    return branch;
+  }
+
+public:
+  class const_iterator {
+    friend class PersistentMap;
+    // The path to the current entry, with the position taken at each
+    // node. Empty at the end.
+    std::vector<std::pair<const Node *, std::size_t>> path;
+
+    explicit const_iterator(const Node *root) {
+      if (root) {
+        path.emplace_back(root, 0);
+        settle();
+      }
+    }
+
+    // Moves down to the first entry at or after the current position.
+    void settle() {
+      while (!path.empty()) {
+        auto &[node, pos] = path.back();
+        if (node->is_leaf() ? pos < node->entries.size()
+                            : pos < node->children.size()) {
+          if (node->is_leaf()) {
+            return;
+          }
+          path.emplace_back(node->children[pos].get(), 0);
+        } else {
+          path.pop_back();
+          if (!path.empty()) {
+            path.back().second++;
+          }
+        }
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PersistentMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return path.back().first->entries[path.back().second];
+    }
+    pointer operator->() const { return &**this; }
+
+    const_iterator &operator++() {
+      path.back().second++;
+      settle();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      if (path.empty() || other.path.empty()) {
+        return path.empty() == other.path.empty();
+      }
+      return path.back() == other.path.back();
+    }
+  };
+  using iterator = const_iterator;
+
+  PersistentMap() = default;
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  const_iterator begin() const { return const_iterator(root.get()); }
+  const_iterator end() const { return const_iterator(); }
+
+  const_iterator find(const Key &key) const {
+    std::size_t hash = Hash{}(key);
+    const_iterator it;
+    const Node *node = root.get();
+    unsigned shift = 0;
+    while (node) {
+      if (node->is_leaf()) {
+        if (node->hash != hash) {
+          return end();
+        }
+        for (std::size_t i = 0; i < node->entries.size(); i++) {
+          if (node->entries[i].first == key) {
+            it.path.emplace_back(node, i);
+            return it;
+          }
+        }
+        return end();
+      }
+      uint32_t bit = uint32_t(1) << slot(hash, shift);
+      if (!(node->bitmap & bit)) {
+        return end();
+      }
+      std::size_t pos = position(node->bitmap, bit);
+      it.path.emplace_back(node, pos);
+      node = node->children[pos].get();
+      shift += bits_per_level;
+    }
+    return end();
+  }
+
+  bool contains(const Key &key) const { return find(key) != end(); }
+
+  const Value &at(const Key &key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("PersistentMap::at");
+    }
+    return it->second;
+  }
+
+  /**
+   * Returns a map with the key set to the value, replacing the value it
+   * had in this one if any.
+   */
+  PersistentMap with(const Key &key, Value value) const {
+    value_type entry(key, std::move(value));
+    bool added = false;
+    NodePtr new_root = insert(root, Hash{}(key), 0, entry, added);
+    return PersistentMap(std::move(new_root), count + (added ? 1 : 0));
+  }
+
+  /**
+   * Returns a map without the key, or a copy of this one if it does not
+   * have it.
+   */
+  PersistentMap without(const Key &key) const {
+    bool removed = false;
+    NodePtr new_root = erase(root, Hash{}(key), 0, key, removed);
+    if (!removed) {
+      return *this;
+    }
+    return PersistentMap(std::move(new_root), count - 1);
+  }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
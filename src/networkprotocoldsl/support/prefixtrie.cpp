@@ -0,0 +1,62 @@
+#include <networkprotocoldsl/support/prefixtrie.hpp>
+
+#include <algorithm>
+
+namespace networkprotocoldsl::support {
+
+PrefixTrie::PrefixTrie(const std::vector<std::string> &strings) {
+  // every byte used by the strings gets a class of its own, class 0
+  // being every other byte.
+  for (const auto &s : strings) {
+    for (unsigned char c : s) {
+      if (byte_class[c] == 0) {
+        byte_class[c] = classes++;
+      }
+    }
+  }
+  nodes.emplace_back();
+  transitions.assign(classes, dead);
+  for (std::size_t id = 0; id < strings.size(); id++) {
+    State state = root;
+    for (unsigned char c : strings[id]) {
+      nodes[state].reachable++;
+      if (nodes[state].reachable == 1) {
+        nodes[state].only = id;
+      }
+      State &next = transitions[state * classes + byte_class[c]];
+      if (next == dead) {
+        next = nodes.size();
+        nodes.emplace_back();
+        transitions.resize(transitions.size() + classes, dead);
+      }
+      // the reference may have moved with the resize.
+      state = transitions[state * classes + byte_class[c]];
+    }
+    nodes[state].reachable++;
+    if (nodes[state].reachable == 1) {
+      nodes[state].only = id;
+    }
+    if (nodes[state].ends == npos) {
+      nodes[state].ends = id;
+    }
+  }
+  for (auto &node : nodes) {
+    if (node.reachable != 1) {
+      node.only = npos;
+    }
+  }
+}
+
+PrefixTrie::State PrefixTrie::walk(State state, std::string_view in,
+                                   std::size_t &passed) const {
+  for (unsigned char c : in) {
+    if (state == dead) {
+      break;
+    }
+    passed = std::min(passed, nodes[state].ends);
+    state = transitions[state * classes + byte_class[c]];
+  }
+  return state;
+}
+
+} // namespace networkprotocoldsl::support
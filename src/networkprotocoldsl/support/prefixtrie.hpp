@@ -0,0 +1,86 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PREFIXTRIE_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_PREFIXTRIE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * Tells which of a list of strings the input starts with, reading the
+ * input a byte at a time, as a deterministic automaton built from the
+ * trie of the strings.
+ *
+ * Each state is a prefix shared by some of the strings, and a
+ * transition is a single lookup in a table indexed by the state and a
+ * class of bytes, the bytes that appear in none of the strings all
+ * being the same class. Moving over a byte costs the same however
+ * many strings there are, and the walk stops at the dead state as soon
+ * as the input is no longer the prefix of any of them.
+ *
+ * The strings are identified by their position in the list. Immutable
+ * once built, so it can be shared by any number of threads.
+ */
+class PrefixTrie {
+public:
+  using State = std::int32_t;
+  static constexpr State root = 0;
+  static constexpr State dead = -1;
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+  struct Node {
+    // the first string that ends at this state.
+    std::size_t ends = npos;
+    // how many strings start with the prefix of this state, and which
+    // one it is when there is a single one.
+    std::size_t reachable = 0;
+    std::size_t only = npos;
+  };
+
+  std::array<std::uint16_t, 256> byte_class{};
+  std::size_t classes = 1;
+  std::vector<Node> nodes;
+  // classes entries per state.
+  std::vector<State> transitions;
+
+public:
+  explicit PrefixTrie(const std::vector<std::string> &strings);
+
+  State step(State state, unsigned char byte) const {
+    if (state == dead) {
+      return dead;
+    }
+    return transitions[state * classes + byte_class[byte]];
+  }
+
+  /**
+   * Moves over the input from the state, and lowers passed to the
+   * first string the input went beyond the end of on the way, that
+   * is, a string that the input starts with and is longer than.
+   */
+  State walk(State state, std::string_view in, std::size_t &passed) const;
+
+  // the first string the input that reached the state is equal to.
+  std::size_t ends_at(State state) const {
+    return state == dead ? npos : nodes[state].ends;
+  }
+  // how many strings the input that reached the state can still become.
+  std::size_t reachable(State state) const {
+    return state == dead ? 0 : nodes[state].reachable;
+  }
+  // the string it can become, when there is only one.
+  std::size_t only_reachable(State state) const {
+    return state == dead ? npos : nodes[state].only;
+  }
+
+  std::size_t states() const { return nodes.size(); }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
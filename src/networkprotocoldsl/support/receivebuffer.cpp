@@ -0,0 +1,42 @@
+#include <networkprotocoldsl/support/receivebuffer.hpp>
+
+#include <algorithm>
+
+namespace networkprotocoldsl::support {
+
+void ReceiveBuffer::append(std::string_view bytes) {
+  if (bytes.empty()) {
+    return;
+  }
+  bool shared = storage && storage.use_count() > 1;
+  if (storage && !shared && read_pos == storage->size()) {
+    // everything was consumed and nobody looks at it anymore.
+    storage->clear();
+    read_pos = 0;
+  }
+  if (storage && storage->size() + bytes.size() <= storage->capacity()) {
+    storage->append(bytes);
+    return;
+  }
+  if (storage && !shared && read_pos == 0) {
+    // let the string double its capacity.
+    storage->append(bytes);
+    return;
+  }
+  std::size_t unconsumed_size = size();
+  auto replacement = std::make_shared<std::string>();
+  replacement->reserve(
+      std::max(initial_capacity, 2 * (unconsumed_size + bytes.size())));
+  if (storage) {
+    replacement->append(std::string_view(*storage).substr(read_pos));
+  }
+  replacement->append(bytes);
+  storage = std::move(replacement);
+  read_pos = 0;
+}
+
+void ReceiveBuffer::consume(std::size_t n) {
+  read_pos = std::min(read_pos + n, storage ? storage->size() : 0);
+}
+
+} // namespace networkprotocoldsl::support
@@ -0,0 +1,61 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_RECEIVEBUFFER_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_RECEIVEBUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * The bytes received on a connection that were not consumed yet, kept
+ * contiguous so a parser can look at all of them at once no matter
+ * how many reads they arrived in.
+ *
+ * New bytes are appended after the unconsumed ones and consuming only
+ * moves the read cursor, so a message that arrives a byte at a time
+ * costs linear time. The storage grows by doubling and is reused once
+ * everything in it was consumed.
+ *
+ * What was consumed may still be referenced by slices of the buffer,
+ * so bytes are never moved or overwritten while anybody else holds on
+ * to it: appending only uses spare capacity, and when there is none
+ * the unconsumed bytes move to a new buffer.
+ *
+ * Not thread safe, it belongs to the thread stepping the interpreter.
+ */
+class ReceiveBuffer {
+  static constexpr std::size_t initial_capacity = 4096;
+
+  std::shared_ptr<std::string> storage;
+  std::size_t read_pos = 0;
+
+public:
+  void append(std::string_view bytes);
+
+  /**
+   * Marks the first n unconsumed bytes as consumed.
+   */
+  void consume(std::size_t n);
+
+  std::string_view unconsumed() const {
+    if (!storage) {
+      return {};
+    }
+    return std::string_view(*storage).substr(read_pos);
+  }
+  std::size_t size() const { return storage ? storage->size() - read_pos : 0; }
+  bool empty() const { return size() == 0; }
+
+  /**
+   * The buffer the unconsumed bytes live in, starting at offset(), for
+   * readers that take slices of it.
+   */
+  std::shared_ptr<const std::string> buffer() const { return storage; }
+  std::size_t offset() const { return read_pos; }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
@@ -0,0 +1 @@
+#include <networkprotocoldsl/support/spscqueue.hpp>
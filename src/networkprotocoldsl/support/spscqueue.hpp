@@ -0,0 +1,116 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_SPSCQUEUE_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_SUPPORT_SPSCQUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace networkprotocoldsl::support {
+
+/**
+ * A bounded queue with a single producer and a single consumer that
+ * does not take any lock.
+ *
+ * The elements live in a ring of slots. The producer only ever writes
+ * the tail and the consumer only ever writes the head, and each of
+ * them publishes its index with a release store once the slot is
+ * filled or emptied, so the other side can acquire it. Both sides keep
+ * the last index they saw of the other one, and only load it again
+ * when that one says the queue is full or empty.
+ *
+ * "Single" means one at a time: the producer (or the consumer) may be
+ * a different thread on each call, as long as the calls are ordered,
+ * like an interpreter that is only stepped by one worker at a time.
+ */
+template <typename T> class SpscQueue {
+  const std::size_t mask;
+  const std::unique_ptr<std::optional<T>[]> slots;
+
+  // Written by the consumer.
+  alignas(64) std::atomic<std::size_t> head = 0;
+  std::size_t cached_tail = 0;
+
+  // Written by the producer.
+  alignas(64) std::atomic<std::size_t> tail = 0;
+  std::size_t cached_head = 0;
+
+public:
+  /**
+   * The capacity is rounded up to a power of two.
+   */
+  explicit SpscQueue(std::size_t capacity)
+      : mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+        slots(new std::optional<T>[mask + 1]) {}
+  SpscQueue(const SpscQueue &in) = delete;
+  SpscQueue(SpscQueue &&in) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  std::size_t capacity() const { return mask + 1; }
+
+  /**
+   * Adds the element unless the queue is full. Called by the producer.
+   */
+  template <typename U> bool try_push(U &&input) {
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head > mask) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (t - cached_head > mask) {
+        return false;
+      }
+    }
+    slots[t & mask].emplace(std::forward<U>(input));
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Adds the element, waiting for the consumer to make room if the
+   * queue is full. Called by the producer.
+   */
+  void push_back(const T &input) {
+    while (!try_push(input)) {
+      std::this_thread::yield();
+    }
+  }
+  void push_back(T &&input) {
+    while (!try_push(std::move(input))) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Takes the oldest element, if any. Called by the consumer.
+   */
+  std::optional<T> pop() {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      if (h == cached_tail) {
+        return std::nullopt;
+      }
+    }
+    std::optional<T> &slot = slots[h & mask];
+    std::optional<T> out(std::move(slot));
+    slot.reset();
+    head.store(h + 1, std::memory_order_release);
+    return out;
+  }
+
+  /**
+   * Whether the queue looked empty. Only a hint when called by the
+   * producer, as the consumer may be taking elements at the same time.
+   */
+  bool empty() const {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+};
+
+} // namespace networkprotocoldsl::support
+
+#endif
@@ -0,0 +1,142 @@
+#include <networkprotocoldsl/operation.hpp>
+#include <networkprotocoldsl/trace.hpp>
+
+#include <chrono>
+#include <iterator>
+
+namespace networkprotocoldsl::trace {
+
+static const char *operation_names[] = {
+    "Add",
+    "DynamicList",
+    "Eq",
+    "FunctionCall",
+    "FunctionCallForEach",
+    "GenerateList",
+    "If",
+    "Int32Literal",
+    "IntToAscii",
+    "LesserEqual",
+    "LexicalPadGet",
+    "LexicalPadInitialize",
+    "LexicalPadInitializeGlobal",
+    "LexicalPadSet",
+    "Multiply",
+    "OpSequence",
+    "ReadInt32Native",
+    "ReadIntFromAscii",
+    "ReadOctetsUntilTerminator",
+    "ReadStaticOctets",
+    "StaticCallable",
+    "Subtract",
+    "TerminateListIfReadAhead",
+    "UnaryCallback",
+    "WriteInt32Native",
+    "WriteOctets",
+    "WriteOctetsWithEscape",
+    "WriteStaticOctets",
+    "DictionaryInitialize",
+    "DictionarySet",
+    "DictionaryGet",
+    "LexicalPadAsDict",
+    "TransitionLookahead",
+    "StateMachineOperation",
+};
+static_assert(std::size(operation_names) == std::variant_size_v<Operation>,
+              "every operation needs a name in the trace output");
+
+static std::array<std::atomic<std::uint64_t>, max_tag / 64> enabled_tags;
+
+static std::uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void TraceRingBuffer::record(int tag, std::size_t operation_index) {
+  std::uint64_t sequence = head.fetch_add(1, std::memory_order_relaxed);
+  Slot &slot = slots[sequence % capacity];
+  slot.guard.store(sequence * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp_ns.store(now_ns(), std::memory_order_relaxed);
+  slot.tag.store(tag, std::memory_order_relaxed);
+  slot.operation_index.store(operation_index, std::memory_order_relaxed);
+  slot.guard.store(sequence * 2 + 2, std::memory_order_release);
+}
+
+std::vector<TraceEntry> TraceRingBuffer::snapshot() const {
+  std::vector<TraceEntry> entries;
+  std::uint64_t end = head.load(std::memory_order_acquire);
+  std::uint64_t begin = end > capacity ? end - capacity : 0;
+  entries.reserve(end - begin);
+  for (std::uint64_t sequence = begin; sequence < end; sequence++) {
+    const Slot &slot = slots[sequence % capacity];
+    std::uint64_t guard = slot.guard.load(std::memory_order_acquire);
+    if (guard != sequence * 2 + 2) {
+      // still being written, or already overwritten by a newer entry.
+      continue;
+    }
+    TraceEntry entry{sequence,
+                     slot.timestamp_ns.load(std::memory_order_relaxed),
+                     slot.tag.load(std::memory_order_relaxed),
+                     slot.operation_index.load(std::memory_order_relaxed)};
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.guard.load(std::memory_order_relaxed) == guard) {
+      entries.push_back(entry);
+    }
+  }
+  return entries;
+}
+
+void TraceRingBuffer::clear() {
+  for (auto &slot : slots) {
+    slot.guard.store(0, std::memory_order_relaxed);
+  }
+  head.store(0, std::memory_order_release);
+}
+
+void enable(int tag) {
+  if (tag >= 0 && tag < max_tag) {
+    enabled_tags[tag / 64].fetch_or(std::uint64_t(1) << (tag % 64),
+                                    std::memory_order_relaxed);
+  }
+}
+
+void disable(int tag) {
+  if (tag >= 0 && tag < max_tag) {
+    enabled_tags[tag / 64].fetch_and(~(std::uint64_t(1) << (tag % 64)),
+                                     std::memory_order_relaxed);
+  }
+}
+
+bool is_enabled(int tag) {
+  if (tag < 0 || tag >= max_tag) {
+    return false;
+  }
+  return enabled_tags[tag / 64].load(std::memory_order_relaxed) &
+         (std::uint64_t(1) << (tag % 64));
+}
+
+TraceRingBuffer &buffer() {
+  static TraceRingBuffer b;
+  return b;
+}
+
+void record(int tag, std::size_t operation_index) {
+  buffer().record(tag, operation_index);
+}
+
+void dump(std::ostream &os) {
+  for (const auto &entry : buffer().snapshot()) {
+    os << entry.sequence << " " << entry.timestamp_ns << " " << entry.tag
+       << " ";
+    if (entry.operation_index < std::size(operation_names)) {
+      os << operation_names[entry.operation_index];
+    } else {
+      os << "<unknown operation>";
+    }
+    os << std::endl;
+  }
+}
+
+} // namespace networkprotocoldsl::trace
@@ -0,0 +1,95 @@
+#ifndef INCLUDED_NETWORKPROTOCOLDSL_TRACE_HPP
+#define INCLUDED_NETWORKPROTOCOLDSL_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * Trace points are only compiled in when the build enables
+ * NETWORKPROTOCOLDSL_ENABLE_TRACING. Otherwise the macro expands to
+ * nothing, and the interpreter does not even check whether tracing
+ * is enabled.
+ */
+#ifdef NETWORKPROTOCOLDSL_ENABLE_TRACING
+#define NETWORKPROTOCOLDSL_TRACE_OPERATION(tag, operation_index)               \
+  do {                                                                         \
+    if (::networkprotocoldsl::trace::is_enabled(tag)) {                        \
+      ::networkprotocoldsl::trace::record(tag, operation_index);              \
+    }                                                                          \
+  } while (0)
+#else
+#define NETWORKPROTOCOLDSL_TRACE_OPERATION(tag, operation_index)
+#endif
+
+namespace networkprotocoldsl::trace {
+
+/**
+ * A single trace record. The tag identifies who executed the
+ * operation, which is the file descriptor when the interpreter is
+ * managed by an InterpreterCollectionManager.
+ */
+struct TraceEntry {
+  std::uint64_t sequence;
+  std::uint64_t timestamp_ns;
+  int tag;
+  std::size_t operation_index;
+};
+
+/**
+ * Fixed size ring buffer of trace entries.
+ *
+ * Writers never block each other: each one claims a sequence number
+ * and writes the slot it maps to, overwriting the oldest entry. Each
+ * slot is guarded by its own sequence counter, which is odd while
+ * the slot is being written, so a reader can tell a torn entry from
+ * a complete one and skip it.
+ */
+class TraceRingBuffer {
+public:
+  static constexpr std::size_t capacity = 4096;
+
+private:
+  struct Slot {
+    std::atomic<std::uint64_t> guard = 0;
+    std::atomic<std::uint64_t> timestamp_ns = 0;
+    std::atomic<int> tag = 0;
+    std::atomic<std::size_t> operation_index = 0;
+  };
+  std::array<Slot, capacity> slots;
+  std::atomic<std::uint64_t> head = 0;
+
+public:
+  void record(int tag, std::size_t operation_index);
+  std::vector<TraceEntry> snapshot() const;
+  void clear();
+};
+
+/**
+ * Tags that can be enabled individually at runtime. Tags outside of
+ * this range are never traced.
+ */
+constexpr int max_tag = 65536;
+
+void enable(int tag);
+void disable(int tag);
+bool is_enabled(int tag);
+
+void record(int tag, std::size_t operation_index);
+
+/**
+ * The process-wide buffer used by the trace points.
+ */
+TraceRingBuffer &buffer();
+
+/**
+ * Writes the entries currently in the buffer, oldest first.
+ */
+void dump(std::ostream &os);
+
+} // namespace networkprotocoldsl::trace
+
+#endif
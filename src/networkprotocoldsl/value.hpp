@@ -3,7 +3,9 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <variant>
 #include <vector>
@@ -39,11 +41,19 @@ struct Callable {
   std::shared_ptr<const OpTree> tree;
   std::vector<std::string> argument_names;
   bool inherits_lexical_pad;
+  // The slot names of the pad the callable runs in, when known ahead
+  // of time. Otherwise the interpreter derives them from the tree.
+  std::shared_ptr<const std::vector<std::string>> pad_layout;
   Callable(std::shared_ptr<const OpTree> t)
       : tree(t), argument_names({}), inherits_lexical_pad(true) {}
   Callable(std::shared_ptr<const OpTree> t,
            const std::vector<std::string> &names, bool inherits)
       : tree(t), argument_names(names), inherits_lexical_pad(inherits) {}
+  Callable(std::shared_ptr<const OpTree> t,
+           const std::vector<std::string> &names, bool inherits,
+           std::shared_ptr<const std::vector<std::string>> layout)
+      : tree(t), argument_names(names), inherits_lexical_pad(inherits),
+        pad_layout(layout) {}
 };
 
 struct DynamicList {
@@ -59,16 +69,140 @@ struct DynamicList {
       : values(vals) {}
 };
 
+/**
+ * Storage for the bytes of an Octets value.
+ *
+ * Payloads that fit in the small-string buffer of std::string are
+ * kept inline, so copying a short token (a verb, a status code, a
+ * domain) neither allocates nor touches a shared reference count.
+ * Longer payloads are shared between copies. Either way the handle
+ * dereferences to a const std::string, like the shared_ptr it
+ * replaces.
+ *
+ * Long payloads read from the network may also be a slice of the
+ * buffer they were received in, which keeps that buffer alive
+ * instead of copying the bytes out of it. view() gives access to the
+ * bytes of any of the three forms without copying; dereferencing a
+ * slice copies it into a string the first time it is asked for.
+ */
+class OctetsData {
+  struct Slice {
+    std::shared_ptr<const std::string> buffer;
+    std::string_view bytes;
+    mutable std::once_flag materialized_flag;
+    mutable std::string materialized;
+    Slice(std::shared_ptr<const std::string> b, std::string_view v)
+        : buffer(std::move(b)), bytes(v) {}
+  };
+
+  std::variant<std::shared_ptr<const std::string>, std::string,
+               std::shared_ptr<const Slice>>
+      storage;
+
+public:
+  static std::size_t inline_capacity() {
+    return std::string().capacity();
+  }
+
+  OctetsData() = default;
+  OctetsData(std::string &&d) {
+    if (d.size() <= inline_capacity()) {
+      storage.emplace<std::string>(std::move(d));
+    } else {
+      storage = std::make_shared<const std::string>(std::move(d));
+    }
+  }
+  OctetsData(const std::string &d) {
+    if (d.size() <= inline_capacity()) {
+      storage.emplace<std::string>(d);
+    } else {
+      storage = std::make_shared<const std::string>(d);
+    }
+  }
+  OctetsData(std::shared_ptr<const std::string> d) {
+    if (d && d->size() <= inline_capacity()) {
+      storage.emplace<std::string>(*d);
+    } else {
+      storage = std::move(d);
+    }
+  }
+  /**
+   * The bytes of buffer starting at offset. Short slices are copied
+   * inline, since that is cheaper than holding on to the buffer.
+   */
+  OctetsData(std::shared_ptr<const std::string> buffer, std::size_t offset,
+             std::size_t length) {
+    std::string_view bytes = std::string_view(*buffer).substr(offset, length);
+    if (bytes.size() <= inline_capacity()) {
+      storage.emplace<std::string>(bytes);
+    } else {
+      storage = std::make_shared<const Slice>(std::move(buffer), bytes);
+    }
+  }
+  // Copying never allocates: inline payloads fit the small-string
+  // buffer and long ones only bump the reference count. Saying so
+  // lets a Value construct the copy in place instead of going
+  // through a temporary.
+  OctetsData(const OctetsData &other) noexcept : storage(other.storage) {}
+  OctetsData(OctetsData &&other) noexcept = default;
+  OctetsData &operator=(const OctetsData &other) noexcept {
+    storage = other.storage;
+    return *this;
+  }
+  OctetsData &operator=(OctetsData &&other) noexcept = default;
+
+  const std::string *get() const {
+    if (const std::string *s = std::get_if<std::string>(&storage)) {
+      return s;
+    } else if (const auto *slice =
+                   std::get_if<std::shared_ptr<const Slice>>(&storage)) {
+      const Slice &sl = **slice;
+      std::call_once(sl.materialized_flag,
+                     [&sl] { sl.materialized.assign(sl.bytes); });
+      return &sl.materialized;
+    } else {
+      return std::get<std::shared_ptr<const std::string>>(storage).get();
+    }
+  }
+  const std::string &operator*() const { return *get(); }
+  const std::string *operator->() const { return get(); }
+  explicit operator bool() const {
+    if (const auto *shared =
+            std::get_if<std::shared_ptr<const std::string>>(&storage)) {
+      return *shared != nullptr;
+    }
+    return true;
+  }
+  std::string_view view() const {
+    if (const std::string *s = std::get_if<std::string>(&storage)) {
+      return *s;
+    } else if (const auto *slice =
+                   std::get_if<std::shared_ptr<const Slice>>(&storage)) {
+      return (*slice)->bytes;
+    } else if (const auto &shared =
+                   std::get<std::shared_ptr<const std::string>>(storage)) {
+      return *shared;
+    }
+    return {};
+  }
+  bool is_inline() const {
+    return std::holds_alternative<std::string>(storage);
+  }
+  bool is_slice() const {
+    return std::holds_alternative<std::shared_ptr<const Slice>>(storage);
+  }
+};
+
 struct Octets {
-  std::shared_ptr<const std::string> data;
+  OctetsData data;
   Octets() = default;
-  explicit Octets(std::string &&d)
-      : data(std::make_shared<const std::string>(std::move(d))) {}
-  explicit Octets(const char *d)
-      : data(std::make_shared<const std::string>(d)) {}
-  explicit Octets(const std::string &d)
-      : data(std::make_shared<const std::string>(d)) {}
-  explicit Octets(std::shared_ptr<const std::string> d) : data(d) {}
+  explicit Octets(std::string &&d) : data(std::move(d)) {}
+  explicit Octets(const char *d) : data(std::string(d)) {}
+  explicit Octets(const std::string &d) : data(d) {}
+  explicit Octets(std::shared_ptr<const std::string> d) : data(std::move(d)) {}
+  Octets(std::shared_ptr<const std::string> buffer, std::size_t offset,
+         std::size_t length)
+      : data(std::move(buffer), offset, length) {}
 };
 
 struct Dictionary {
@@ -6,8 +6,12 @@
 #include <functional>
 #include <iostream>
 #include <networkprotocoldsl/support/mutexlockqueue.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <uv.h>
+#include <vector>
 
 namespace networkprotocoldsl_uv {
 using namespace networkprotocoldsl;
@@ -28,6 +32,9 @@ struct UvConnectionData {
   LibuvContext *context;
   uv_tcp_t conn;
   int fd;
+  // What was read while the input queue of the interpreter was full,
+  // only touched by the loop thread.
+  std::optional<std::string> held_input;
 };
 
 void alloc_buffer_cb(uv_handle_t *handle, size_t suggested, uv_buf_t *buf) {
@@ -61,21 +68,59 @@ void on_read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
   }
   if (nread > 0) {
     std::string input_data(buf->base, nread);
-    // Push data to input_buffer.
-    it->second->input_buffer.push_back(input_data);
-    // Notify the interpreter that input is available.
-    collection->signals->wake_up_for_input.notify();
-    collection->signals->wake_up_interpreter.notify();
+    // Push data to input_buffer, or keep it and stop reading until the
+    // interpreter made room, as the loop thread never waits for it.
+    // try_push leaves the data alone when it fails.
+    if (!it->second->input_buffer.try_push(std::move(input_data))) {
+      conn_data->held_input = std::move(input_data);
+      uv_read_stop(stream);
+      it->second->input_paused.store(true);
+    }
+    // Let the interpreter know that input is available.
+    collection->signals->schedule(it->second);
   } else if (nread < 0) {
     // Handle error/connection close (optional: mark EOF).
     it->second->eof.store(true);
-    collection->signals->wake_up_for_input.notify();
-    collection->signals->wake_up_interpreter.notify();
+    collection->signals->schedule(it->second);
   }
   if (buf->base)
     free(buf->base);
 }
 
+// Hands over what was held back and reads from the connection again,
+// called in the loop thread once the interpreter drained its queue.
+static void resume_reading(UvConnectionData *conn_data) {
+  if (uv_is_closing(reinterpret_cast<uv_handle_t *>(&conn_data->conn))) {
+    return;
+  }
+  auto collection = conn_data->context->mgr->get_collection();
+  auto it = collection->interpreters.find(conn_data->fd);
+  if (it == collection->interpreters.end()) {
+    return;
+  }
+  if (conn_data->held_input.has_value()) {
+    if (!it->second->input_buffer.try_push(
+            std::move(*conn_data->held_input))) {
+      it->second->input_paused.store(true);
+      collection->signals->schedule(it->second);
+      return;
+    }
+    conn_data->held_input.reset();
+    collection->signals->schedule(it->second);
+  }
+  uv_read_start(reinterpret_cast<uv_stream_t *>(&conn_data->conn),
+                alloc_buffer_cb, on_read_cb);
+}
+
+// Everything the connection had to send when the pusher looked at it,
+// written with a single uv_write. The chunks keep the bytes alive
+// until the write completes.
+struct WriteRequest {
+  uv_write_t req;
+  std::vector<value::Octets> chunks;
+  std::vector<uv_buf_t> bufs;
+};
+
 // Updated free static write callback using UvConnectionData directly.
 static void on_write_completed(uv_write_t *req, int status) {
   auto *conn_data = static_cast<UvConnectionData *>(req->data);
@@ -84,13 +129,13 @@ static void on_write_completed(uv_write_t *req, int status) {
   if (it != collection->interpreters.end() && status < 0) {
     it->second->eof.store(true);
     collection->signals->wake_up_for_output.notify();
-    collection->signals->wake_up_interpreter.notify();
+    collection->signals->schedule(it->second);
     uv_read_stop(reinterpret_cast<uv_stream_t *>(&conn_data->conn));
     // Use unified_close_cb here.
     uv_close(reinterpret_cast<uv_handle_t *>(&conn_data->conn),
              unified_close_cb);
   }
-  delete req;
+  delete reinterpret_cast<WriteRequest *>(req);
 }
 
 // Updated pusher thread loop to use UvConnectionData in the write callback.
@@ -118,26 +163,37 @@ void pusher_thread_loop(LibuvClientRunner *r, UvConnectionData *data) {
       }
       return;
     }
-    // Drain all outgoing data from the interpreter's output_buffer.
     auto &interpreter_context = it->second;
-    while (true) {
-      auto output_opt = interpreter_context->output_buffer.pop();
-      if (output_opt.has_value()) {
-        did_something = true;
-        std::string output = output_opt.value();
-        // Enqueue a write task using UvConnectionData for the callback.
-        data->context->work_queue->push_work([data, output, collection]() {
-          uv_write_t *req = new uv_write_t;
-          req->data = data; // set UvConnectionData as the write callback data.
-          uv_buf_t wrbuf =
-              uv_buf_init(const_cast<char *>(output.data()), output.size());
-          uv_write(req, reinterpret_cast<uv_stream_t *>(&data->conn), &wrbuf, 1,
-                   on_write_completed);
-        });
-      } else {
-        // No more data in buffer
-        break;
+    // The loop stopped reading from the connection when its input
+    // queue was full, and the interpreter took everything since.
+    if (interpreter_context->input_paused.load() &&
+        interpreter_context->input_buffer.empty() &&
+        interpreter_context->input_paused.exchange(false)) {
+      data->context->work_queue->push_work(
+          [data]() { resume_reading(data); });
+    }
+    // Drain all outgoing data from the interpreter's output_buffer,
+    // to be sent with a single write.
+    std::vector<value::Octets> chunks;
+    while (auto output = interpreter_context->output_buffer.pop()) {
+      chunks.push_back(std::move(*output));
+    }
+    if (!chunks.empty()) {
+      did_something = true;
+      auto *request = new WriteRequest{{}, std::move(chunks), {}};
+      for (const auto &chunk : request->chunks) {
+        std::string_view bytes = chunk.data.view();
+        request->bufs.push_back(
+            uv_buf_init(const_cast<char *>(bytes.data()), bytes.size()));
       }
+      // set UvConnectionData as the write callback data.
+      request->req.data = data;
+      // Enqueue a write task using UvConnectionData for the callback.
+      data->context->work_queue->push_work([data, request, collection]() {
+        uv_write(&request->req, reinterpret_cast<uv_stream_t *>(&data->conn),
+                 request->bufs.data(), request->bufs.size(),
+                 on_write_completed);
+      });
     }
     // If nothing was found, wait for wake_up_for_output notification.
     // But only if the collection hasn't changed and the interpreter hasn't
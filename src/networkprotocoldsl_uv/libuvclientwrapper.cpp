@@ -21,7 +21,6 @@ LibuvClientWrapper::~LibuvClientWrapper() {
   runner_.exit_when_done.store(true);
   auto collection = mgr_.get_collection();
   collection->signals->wake_up_for_output.notify();
-  collection->signals->wake_up_for_input.notify();
   collection->signals->wake_up_for_callback.notify();
   collection->signals->wake_up_interpreter.notify();
 
@@ -44,7 +43,6 @@ LibuvClientWrapper::start(const std::string &ip, int port) {
 std::future<networkprotocoldsl::Value> &LibuvClientWrapper::result() {
   runner_.exit_when_done.store(true);
   mgr_.get_collection()->signals->wake_up_for_output.notify();
-  mgr_.get_collection()->signals->wake_up_for_input.notify();
   mgr_.get_collection()->signals->wake_up_for_callback.notify();
   mgr_.get_collection()->signals->wake_up_interpreter.notify();
   return uv_client_runner_->client_result;
@@ -5,8 +5,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <uv.h>
+#include <vector>
 
 namespace networkprotocoldsl_uv {
 using namespace networkprotocoldsl;
@@ -29,28 +33,40 @@ struct UvConnectionData {
   std::atomic<bool> connection_close_request_sent{false};
   uv_tcp_t conn;
   int fd;
+  // What was read while the input queue of the interpreter was full,
+  // only touched by the loop thread.
+  std::optional<std::string> held_input;
 };
 
+static void resume_reading(UvConnectionData *conn_data);
+
 static void on_close_cb(uv_handle_t *handle) {
   auto *conn_data = static_cast<UvConnectionData *>(handle->data);
+  // the pusher thread waits for the connections to be closed.
   auto collection = conn_data->runner->mgr_->get_collection();
-  collection->signals->wake_up_for_callback.notify();
-  collection->signals->wake_up_for_input.notify();
   collection->signals->wake_up_for_output.notify();
-  collection->signals->wake_up_interpreter.notify();
   delete static_cast<UvConnectionData *>(handle->data);
 }
 
+// Everything a connection had to send when the pusher looked at it,
+// written with a single uv_write. The chunks keep the bytes alive
+// until the write completes.
+struct WriteRequest {
+  uv_write_t req;
+  std::vector<value::Octets> chunks;
+  std::vector<uv_buf_t> bufs;
+};
+
 static void on_write_completed(uv_write_t *req, int status) {
   auto *conn_data = static_cast<UvConnectionData *>(req->data);
   auto collection = conn_data->runner->mgr_->get_collection();
   auto it = collection->interpreters.find(conn_data->fd);
   if (it != collection->interpreters.end() && status < 0) {
     it->second->eof.store(true);
-    collection->signals->wake_up_interpreter.notify();
+    collection->signals->schedule(it->second);
     uv_read_stop(reinterpret_cast<uv_stream_t *>(&conn_data->conn));
   }
-  delete req;
+  delete reinterpret_cast<WriteRequest *>(req);
 }
 
 static void pusher_thread_loop_all(LibuvServerRunnerImpl *impl) {
@@ -80,26 +96,38 @@ static void pusher_thread_loop_all(LibuvServerRunnerImpl *impl) {
       }
       active_interpreters++;
 
-      // Drain all outgoing data from the interpreter's output_buffer.
-      while (true) {
-        auto output_opt = entry.second->output_buffer.pop();
-        if (output_opt.has_value()) {
-          blocked_interpreters++;
-          collection->signals->wake_up_interpreter.notify();
-          std::string output = output_opt.value();
-          impl->work_queue->push_work([conn_data, output, collection]() {
-            uv_write_t *req = new uv_write_t;
-            req->data = conn_data;
-            uv_buf_t wrbuf =
-                uv_buf_init(const_cast<char *>(output.data()), output.size());
-            uv_write(req, reinterpret_cast<uv_stream_t *>(&conn_data->conn),
-                     &wrbuf, 1, on_write_completed);
-          });
-        } else {
-          // No more data in buffer
-          break;
-        }
+      // The loop stopped reading from the connection when its input
+      // queue was full, and the interpreter took everything since.
+      if (interpreter->input_paused.load() &&
+          interpreter->input_buffer.empty() &&
+          interpreter->input_paused.exchange(false)) {
+        impl->work_queue->push_work(
+            [conn_data]() { resume_reading(conn_data); });
+      }
+
+      // Drain all outgoing data from the interpreter's output_buffer,
+      // to be sent with a single write.
+      std::vector<value::Octets> chunks;
+      while (auto output = entry.second->output_buffer.pop()) {
+        chunks.push_back(std::move(*output));
+      }
+      if (chunks.empty()) {
+        continue;
       }
+      blocked_interpreters++;
+      auto *request = new WriteRequest{{}, std::move(chunks), {}};
+      for (const auto &chunk : request->chunks) {
+        std::string_view bytes = chunk.data.view();
+        request->bufs.push_back(
+            uv_buf_init(const_cast<char *>(bytes.data()), bytes.size()));
+      }
+      request->req.data = conn_data;
+      impl->work_queue->push_work([conn_data, request, collection]() {
+        uv_write(&request->req,
+                 reinterpret_cast<uv_stream_t *>(&conn_data->conn),
+                 request->bufs.data(), request->bufs.size(),
+                 on_write_completed);
+      });
     }
     if (impl->exit_when_done.load() && active_interpreters == 0) {
       impl->server_stopped.set_value();
@@ -141,18 +169,49 @@ static void server_on_read_cb(uv_stream_t *stream, ssize_t nread,
   }
   if (nread > 0) {
     std::string input(buf->base, nread);
-    it->second->input_buffer.push_back(input);
-    collection->signals->wake_up_for_input.notify();
-    collection->signals->wake_up_interpreter.notify();
+    // The loop thread never waits for an interpreter, so when the
+    // queue is full the chunk is kept and the connection is not read
+    // until the interpreter made room. try_push leaves the chunk alone
+    // when it fails.
+    if (!it->second->input_buffer.try_push(std::move(input))) {
+      data->held_input = std::move(input);
+      uv_read_stop(stream);
+      it->second->input_paused.store(true);
+    }
+    collection->signals->schedule(it->second);
   } else if (nread < 0) {
     it->second->eof.store(true);
-    collection->signals->wake_up_for_input.notify();
-    collection->signals->wake_up_interpreter.notify();
+    collection->signals->schedule(it->second);
   }
   if (buf->base)
     free(buf->base);
 }
 
+// Hands over what was held back and reads from the connection again,
+// called in the loop thread once the interpreter drained its queue.
+static void resume_reading(UvConnectionData *conn_data) {
+  if (uv_is_closing(reinterpret_cast<uv_handle_t *>(&conn_data->conn))) {
+    return;
+  }
+  auto collection = conn_data->runner->mgr_->get_collection();
+  auto it = collection->interpreters.find(conn_data->fd);
+  if (it == collection->interpreters.end()) {
+    return;
+  }
+  if (conn_data->held_input.has_value()) {
+    if (!it->second->input_buffer.try_push(
+            std::move(*conn_data->held_input))) {
+      it->second->input_paused.store(true);
+      collection->signals->schedule(it->second);
+      return;
+    }
+    conn_data->held_input.reset();
+    collection->signals->schedule(it->second);
+  }
+  uv_read_start(reinterpret_cast<uv_stream_t *>(&conn_data->conn),
+                server_alloc_buffer_cb, server_on_read_cb);
+}
+
 // New connection callback for the server.
 static void on_new_connection_cb(uv_stream_t *server, int status) {
   if (status != 0)
@@ -174,11 +233,6 @@ static void on_new_connection_cb(uv_stream_t *server, int status) {
                                                   std::nullopt, conn_data);
       uv_read_start(reinterpret_cast<uv_stream_t *>(&conn_data->conn),
                     server_alloc_buffer_cb, server_on_read_cb);
-      auto collection = conn_data->runner->mgr_->get_collection();
-      collection->signals->wake_up_for_input.notify();
-      collection->signals->wake_up_interpreter.notify();
-      collection->signals->wake_up_for_output.notify();
-      collection->signals->wake_up_for_callback.notify();
     } else {
       uv_close(reinterpret_cast<uv_handle_t *>(&conn_data->conn), on_close_cb);
     }
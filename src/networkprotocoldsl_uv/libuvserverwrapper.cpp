@@ -44,7 +44,6 @@ void LibuvServerWrapper::stop() {
   // Signal the interpreter to exit.
   runner_.exit_when_done.store(true);
   mgr_.get_collection()->signals->wake_up_for_output.notify();
-  mgr_.get_collection()->signals->wake_up_for_input.notify();
   mgr_.get_collection()->signals->wake_up_for_callback.notify();
   mgr_.get_collection()->signals->wake_up_interpreter.notify();
   // Join threads.
@@ -307,44 +307,35 @@ TEST(recursive_factorial, complete) {
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(1, std::get<int32_t>(std::get<Value>(i1.get_result())));
 
-  // unwinding recursion now
+  // unwinding recursion now, the branches of the if are called in tail
+  // position, so they return straight to the caller of factorial.
   // returns 1
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(1, std::get<int32_t>(std::get<Value>(i1.get_result())));
-  ASSERT_EQ(ContinuationState::Ready, i1.step());
-  ASSERT_EQ(1, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // multiply by 2
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(2, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // returns 2
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(2, std::get<int32_t>(std::get<Value>(i1.get_result())));
-  ASSERT_EQ(ContinuationState::Ready, i1.step());
-  ASSERT_EQ(2, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // multiply by 3
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(6, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // returns 6
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(6, std::get<int32_t>(std::get<Value>(i1.get_result())));
-  ASSERT_EQ(ContinuationState::Ready, i1.step());
-  ASSERT_EQ(6, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // multiply by 4
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(24, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // returns 24
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(24, std::get<int32_t>(std::get<Value>(i1.get_result())));
-  ASSERT_EQ(ContinuationState::Ready, i1.step());
-  ASSERT_EQ(24, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // multiply by 5
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(120, std::get<int32_t>(std::get<Value>(i1.get_result())));
   // returns 120
   ASSERT_EQ(ContinuationState::Ready, i1.step());
   ASSERT_EQ(120, std::get<int32_t>(std::get<Value>(i1.get_result())));
-  ASSERT_EQ(ContinuationState::Ready, i1.step());
-  ASSERT_EQ(120, std::get<int32_t>(std::get<Value>(i1.get_result())));
 
   // final
   ASSERT_EQ(ContinuationState::Exited, i1.step());
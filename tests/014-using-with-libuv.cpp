@@ -74,7 +74,8 @@ static void on_close_connection(uv_handle_t *handle) {
 }
 
 static void on_write_finished(uv_write_t *req, int status) {
-  std::optional<std::string> *cbdata = (std::optional<std::string> *)req->data;
+  std::optional<value::Octets> *cbdata =
+      (std::optional<value::Octets> *)req->data;
   delete cbdata;
   delete req;
 }
@@ -105,14 +106,15 @@ void OutputRunner::run(InterpreterCollectionManager &mgr) {
       }
       active_interpreters++;
       auto cbdata =
-          new std::optional<std::string>(context->output_buffer.pop());
+          new std::optional<value::Octets>(context->output_buffer.pop());
       if (cbdata->has_value()) {
         output_count++;
         conn_data->uv_data->work_on_loop_thread.push_back([conn_data, cbdata] {
           uv_write_t *req = new uv_write_t;
           req->data = cbdata;
           uv_buf_t wrbuf =
-              uv_buf_init(cbdata->value().data(), cbdata->value().size());
+              uv_buf_init(const_cast<char *>(cbdata->value().data.view().data()),
+                          cbdata->value().data.view().size());
           uv_write(req, (uv_stream_t *)&conn_data->conn, &wrbuf, 1,
                    on_write_finished);
         });
@@ -144,10 +146,10 @@ void on_read(uv_stream_t *client, ssize_t nread, const uv_buf_t *buf) {
     if (nread > 0) {
       std::string input = std::string(buf->base, nread);
       ctx_it->second->input_buffer.push_back(input);
-      collection->signals->wake_up_interpreter.notify();
     } else {
       ctx_it->second->eof.store(true);
     }
+    collection->signals->schedule(ctx_it->second);
   }
   if (buf->base) {
     free(buf->base);
@@ -227,7 +229,10 @@ static void on_connect_client(uv_connect_t *client, int status) {
         get_request_for_client(count), conn_data));
     int rc = uv_read_start((uv_stream_t *)handle, alloc_buffer, on_read);
     if (rc != 0) {
-      uv_data->mgr.get_collection()->interpreters.at(fd)->eof.store(true);
+      auto collection = uv_data->mgr.get_collection();
+      auto &context = collection->interpreters.at(fd);
+      context->eof.store(true);
+      collection->signals->schedule(context);
       fprintf(stderr, "Client %i failed to uv_read_start: %s\n", fd,
               uv_strerror(rc));
     }
@@ -8,7 +8,7 @@ using namespace networkprotocoldsl::operation;
 
 TEST(TransitionLookaheadTest, MatchEOFCondition) {
   TransitionLookahead lookahead{
-      {{TransitionLookahead::EOFCondition{}, "EOFState"}}};
+      {{TransitionLookahead::EOFCondition{}, 3}}};
 
   InputOutputOperationContext ctx;
   ctx.eof = true;
@@ -16,49 +16,47 @@ TEST(TransitionLookaheadTest, MatchEOFCondition) {
   auto result = lookahead(ctx, {});
   ASSERT_TRUE(std::holds_alternative<Value>(result));
   auto v = std::get<Value>(result);
-  ASSERT_TRUE(std::holds_alternative<value::Octets>(v));
-  auto octets = std::get<value::Octets>(v);
-  EXPECT_EQ(*(octets.data), "EOFState");
+  ASSERT_TRUE(std::holds_alternative<int32_t>(v));
+  EXPECT_EQ(std::get<int32_t>(v), 3);
 }
 
 TEST(TransitionLookaheadTest, MatchUntilTerminatorCondition) {
   TransitionLookahead lookahead{
-      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, "TerminatorState"}}};
+      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, 1}}};
 
   InputOutputOperationContext ctx;
-  ctx.buffer = "Hello\r\nWorld";
+  lookahead.handle_read(ctx, "Hello\r\nWorld");
 
   auto result = lookahead(ctx, {});
   ASSERT_TRUE(std::holds_alternative<Value>(result));
   auto &v = std::get<Value>(result);
-  ASSERT_TRUE(std::holds_alternative<value::Octets>(v));
-  EXPECT_EQ(*std::get<value::Octets>(v).data, "TerminatorState");
+  ASSERT_TRUE(std::holds_alternative<int32_t>(v));
+  EXPECT_EQ(std::get<int32_t>(v), 1);
 }
 
 TEST(TransitionLookaheadTest, MatchStaticStringCondition) {
   TransitionLookahead lookahead{
-      {std::make_pair<TransitionLookahead::TransitionCondition, std::string>(
-          "Hello", "StaticStringState")}};
+      {std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+          "Hello", 2)}};
 
   InputOutputOperationContext ctx;
-  ctx.buffer = "HelloWorld";
+  lookahead.handle_read(ctx, "HelloWorld");
   auto result = lookahead(ctx, {});
   ASSERT_TRUE(std::holds_alternative<Value>(result));
   auto v = std::get<Value>(result);
-  ASSERT_TRUE(std::holds_alternative<value::Octets>(v));
-  auto octets = std::get<value::Octets>(v);
-  EXPECT_EQ(*(octets.data), "StaticStringState");
+  ASSERT_TRUE(std::holds_alternative<int32_t>(v));
+  EXPECT_EQ(std::get<int32_t>(v), 2);
 }
 
 TEST(TransitionLookaheadTest, NoMatchCondition) {
   TransitionLookahead lookahead{
-      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, "TerminatorState"},
-       std::make_pair<TransitionLookahead::TransitionCondition, std::string>(
-           "Hello", "StaticStringState")}};
+      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, 0},
+       std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+           "Hello", 1)}};
 
   InputOutputOperationContext ctx;
   ctx.eof = false;
-  ctx.buffer = "Goodbye";
+  lookahead.handle_read(ctx, "Hel");
 
   auto result = lookahead(ctx, {});
   ASSERT_TRUE(std::holds_alternative<ReasonForBlockedOperation>(result));
@@ -68,14 +66,102 @@ TEST(TransitionLookaheadTest, NoMatchCondition) {
 
 TEST(TransitionLookaheadTest, ProtocolMismatchError) {
   TransitionLookahead lookahead{
-      {std::make_pair<TransitionLookahead::TransitionCondition, std::string>(
-          "Hello", "StaticStringState")}};
+      {std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+          "Hello", 2)}};
 
   InputOutputOperationContext ctx;
-  ctx.buffer = "Goodbye";
+  lookahead.handle_read(ctx, "Goodbye");
 
   auto result = lookahead(ctx, {});
   ASSERT_TRUE(std::holds_alternative<Value>(result));
   EXPECT_EQ(std::get<value::RuntimeError>(std::get<Value>(result)),
             value::RuntimeError::ProtocolMismatchError);
 }
+
+TEST(TransitionLookaheadTest, UniquePrefixDecides) {
+  TransitionLookahead lookahead{
+      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, 0},
+       std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+           "Hello", 1)}};
+
+  // only the terminator can still be found after a mismatch on "Hello".
+  InputOutputOperationContext ctx;
+  lookahead.handle_read(ctx, "Goodbye");
+  ASSERT_TRUE(lookahead.ready_to_evaluate(ctx));
+  auto result = lookahead(ctx, {});
+  ASSERT_TRUE(std::holds_alternative<Value>(result));
+  EXPECT_EQ(std::get<int32_t>(std::get<Value>(result)), 0);
+}
+
+TEST(TransitionLookaheadTest, EOFIsNotTakenEarly) {
+  TransitionLookahead lookahead{
+      {{TransitionLookahead::EOFCondition{}, 0},
+       std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+           "Hello", 1)}};
+
+  InputOutputOperationContext ctx;
+  EXPECT_FALSE(lookahead.ready_to_evaluate(ctx));
+  ctx.eof = true;
+  auto result = lookahead(ctx, {});
+  ASSERT_TRUE(std::holds_alternative<Value>(result));
+  EXPECT_EQ(std::get<int32_t>(std::get<Value>(result)), 0);
+}
+
+TEST(TransitionLookaheadTest, ReadsOnlyLookAtNewBytes) {
+  TransitionLookahead lookahead{
+      {{TransitionLookahead::MatchUntilTerminator{"\r\n"}, 0},
+       std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+           "HELP", 1),
+       std::make_pair<TransitionLookahead::TransitionCondition, int32_t>(
+           "HELO", 2)}};
+
+  // the same input, growing a byte at a time, as the receive buffer
+  // would, with the terminator split across two reads.
+  std::string input = "HELO x\r\n";
+  InputOutputOperationContext ctx;
+  for (std::size_t i = 1; i <= input.size(); i++) {
+    EXPECT_EQ(lookahead.handle_read(ctx, std::string_view(input).substr(0, i)),
+              0);
+    EXPECT_TRUE(ctx.buffer.empty());
+    if (i < 4) {
+      EXPECT_FALSE(lookahead.ready_to_evaluate(ctx));
+    }
+  }
+  EXPECT_EQ(ctx.lookahead.seen, input.size());
+  auto result = lookahead(ctx, {});
+  ASSERT_TRUE(std::holds_alternative<Value>(result));
+  // the terminator is listed first.
+  EXPECT_EQ(std::get<int32_t>(std::get<Value>(result)), 0);
+
+  // a read that brings nothing new changes nothing.
+  lookahead.handle_read(ctx, input);
+  EXPECT_EQ(ctx.lookahead.seen, input.size());
+}
+
+TEST(TransitionLookaheadTest, CommandsSharingPrefixes) {
+  std::vector<std::pair<TransitionLookahead::TransitionCondition, int32_t>>
+      conditions;
+  for (const char *command : {"HELO ", "EHLO ", "MAIL FROM:", "RCPT TO:",
+                              "RSET\r\n", "QUIT\r\n"}) {
+    conditions.emplace_back(std::string(command), conditions.size());
+  }
+  conditions.emplace_back(TransitionLookahead::EOFCondition{}, 6);
+  TransitionLookahead lookahead{conditions};
+
+  // "R" could still be RCPT or RSET, "RS" only RSET.
+  InputOutputOperationContext ctx;
+  lookahead.handle_read(ctx, "R");
+  EXPECT_FALSE(lookahead.ready_to_evaluate(ctx));
+  lookahead.handle_read(ctx, "RS");
+  ASSERT_TRUE(lookahead.ready_to_evaluate(ctx));
+  auto result = lookahead(ctx, {});
+  EXPECT_EQ(std::get<int32_t>(std::get<Value>(result)), 4);
+
+  // a mismatch is known at the first byte that is no command's.
+  InputOutputOperationContext mismatch;
+  lookahead.handle_read(mismatch, "X");
+  ASSERT_TRUE(lookahead.ready_to_evaluate(mismatch));
+  result = lookahead(mismatch, {});
+  EXPECT_EQ(std::get<value::RuntimeError>(std::get<Value>(result)),
+            value::RuntimeError::ProtocolMismatchError);
+}
@@ -98,4 +98,52 @@ TEST(StateMachineOperationTest, BasicStateTransition) {
   ASSERT_TRUE(std::holds_alternative<Value>(result));
   auto v = std::get<Value>(result);
   ASSERT_TRUE(std::holds_alternative<value::Dictionary>(v));
-}
\ No newline at end of file
+}
+TEST(StateMachineOperationTest, TransitionById) {
+  StateMachineOperation::StateMap states;
+  states["Open"].transitions["zeta"] =
+      StateMachineOperation::TransitionInfo{nullptr, {}, "Closed"};
+  states["Open"].transitions["alpha"] =
+      StateMachineOperation::TransitionInfo{nullptr, {}, "Open"};
+  states["Closed"];
+
+  // IDs follow the sorted order of the names.
+  auto ids =
+      StateMachineOperation::transition_ids(states["Open"].transitions);
+  ASSERT_EQ(0, ids.at("alpha"));
+  ASSERT_EQ(1, ids.at("zeta"));
+
+  StateMachineOperation stateMachine(states);
+  ControlFlowOperationContext ctx;
+  stateMachine(ctx, {});
+  stateMachine.set_callable_invoked(ctx);
+  stateMachine.set_callable_return(
+      ctx, value::DynamicList{int32_t(2), value::Dictionary{}});
+  auto result = stateMachine(ctx, {});
+  ASSERT_TRUE(std::holds_alternative<Value>(result));
+  ASSERT_EQ(value::RuntimeError::NameError,
+            std::get<value::RuntimeError>(std::get<Value>(result)));
+
+  ctx = ControlFlowOperationContext{};
+  stateMachine(ctx, {});
+  stateMachine.set_callable_invoked(ctx);
+  stateMachine.set_callable_return(
+      ctx, value::DynamicList{ids.at("zeta"), value::Dictionary{}});
+  result = stateMachine(ctx, {});
+  ASSERT_EQ(ReasonForBlockedOperation::WaitingForCallableInvocation,
+            std::get<ReasonForBlockedOperation>(result));
+  stateMachine.set_callable_invoked(ctx);
+  stateMachine.set_callable_return(
+      ctx, value::DynamicList{value::Dictionary{}});
+  result = stateMachine(ctx, {});
+  ASSERT_EQ(ReasonForBlockedOperation::WaitingForCallableInvocation,
+            std::get<ReasonForBlockedOperation>(result));
+
+  // the "Closed" state ends the state machine with its dictionary.
+  stateMachine.set_callable_invoked(ctx);
+  stateMachine.set_callable_return(
+      ctx, value::DynamicList{int32_t(0), value::Dictionary{}});
+  result = stateMachine(ctx, {});
+  ASSERT_TRUE(std::holds_alternative<value::Dictionary>(
+      std::get<Value>(result)));
+}
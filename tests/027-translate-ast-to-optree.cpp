@@ -122,16 +122,17 @@ TEST(TranslateASTToOptree, Translation) {
           auto cbdata = context->output_buffer.pop();
           if (cbdata.has_value()) {
             all_exited = false;
-            this_writes << cbdata.value();
+            this_writes << cbdata->data.view();
             auto other_col = other_mgr.get_collection();
             auto other_iter = other_col->interpreters.find(0);
             if (other_iter != other_col->interpreters.end()) {
-              std::cerr << "[" << name << ":" << std::this_thread::get_id() << "] Pushing data to other interpreter: " << cbdata.value()
+              std::cerr << "[" << name << ":" << std::this_thread::get_id() << "] Pushing data to other interpreter: " << cbdata->data.view()
                         << std::endl;
-              other_iter->second->input_buffer.push_back(cbdata.value());
+              other_iter->second->input_buffer.push_back(
+                std::string(cbdata->data.view()));
               other_col->signals->wake_up_for_input.notify();
               other_col->signals->wake_up_for_output.notify();
-              other_col->signals->wake_up_interpreter.notify();
+              other_col->signals->schedule(other_iter->second);
             }
           } else {
             // No more data in buffer
@@ -147,7 +148,7 @@ TEST(TranslateASTToOptree, Translation) {
             other_iter->second->eof.store(true);
             other_col->signals->wake_up_for_input.notify();
             other_col->signals->wake_up_for_output.notify();
-            other_col->signals->wake_up_interpreter.notify();
+            other_col->signals->schedule(other_iter->second);
           }
         } else {
           all_exited = false;
@@ -288,3 +288,50 @@ TEST(EscapeReplacementOperations, StringifyWithoutEscape) {
   // Should not have escape info
   EXPECT_TRUE(read_str.find("escape_char") == std::string::npos);
 }
+
+// Reading from a reference counted buffer keeps a slice of it, unless
+// an escape sequence changed the bytes.
+TEST(EscapeReplacementOperations, ReadKeepsSliceOfInputWhenUnescaped) {
+  using namespace networkprotocoldsl;
+
+  std::string value(64, 'x');
+  auto input = std::make_shared<const std::string>(value + "\r\n");
+
+  operation::ReadOctetsUntilTerminator read_with_escape("\r\n", "\n", "\r\n ");
+  auto optree = std::make_shared<OpTree>(OpTree({read_with_escape, {}}));
+  InterpretedProgram p(optree);
+  Interpreter i = p.get_instance();
+
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(input->size(), i.handle_read(input));
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+
+  auto octets = std::get<value::Octets>(std::get<Value>(i.get_result()));
+  EXPECT_TRUE(octets.data.is_slice());
+  EXPECT_EQ(input->data(), octets.data.view().data());
+  EXPECT_EQ(value, *(octets.data));
+}
+
+TEST(EscapeReplacementOperations, ReadCopiesWhenEscapeReplaced) {
+  using namespace networkprotocoldsl;
+
+  std::string value(64, 'x');
+  auto input = std::make_shared<const std::string>(value + "\r\n " + value +
+                                                   "\r\n");
+
+  operation::ReadOctetsUntilTerminator read_with_escape("\r\n", "\n", "\r\n ");
+  auto optree = std::make_shared<OpTree>(OpTree({read_with_escape, {}}));
+  InterpretedProgram p(optree);
+  Interpreter i = p.get_instance();
+
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  // an incomplete read consumes all but what may start a terminator
+  // or escape sequence, and the next one carries on from there.
+  ASSERT_EQ(68, i.handle_read(std::string_view(*input).substr(0, 70)));
+  ASSERT_EQ(input->size() - 68, i.handle_read(input, 68));
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+
+  auto octets = std::get<value::Octets>(std::get<Value>(i.get_result()));
+  EXPECT_FALSE(octets.data.is_slice());
+  EXPECT_EQ(value + "\n" + value, *(octets.data));
+}
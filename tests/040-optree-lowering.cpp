@@ -0,0 +1,74 @@
+#include <networkprotocoldsl/continuation.hpp>
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(optree_lowering, children_are_contiguous) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(10);
+  operation::Int32Literal il2(20);
+  operation::Add add;
+  operation::OpSequence ops;
+
+  OpTree optree({ops,
+                 {
+                     {il1, {}},
+                     {add, {{il2, {}}, {il1, {}}}},
+                     {il2, {}},
+                 }});
+
+  ASSERT_EQ(6, optree.instructions.size());
+  ASSERT_EQ(&optree.root, optree.instructions[0].node);
+  ASSERT_EQ(&optree.root.operation, optree.instructions[0].operation);
+  ASSERT_EQ(1, optree.instructions[0].first_child);
+  ASSERT_EQ(3, optree.instructions[0].children_count);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_EQ(&optree.root.children[i], optree.instructions[1 + i].node);
+  }
+  const OpTreeInstruction &add_ins = optree.instructions[2];
+  ASSERT_EQ(2, add_ins.children_count);
+  ASSERT_EQ(&optree.root.children[1].children[0],
+            optree.instructions[add_ins.first_child].node);
+  ASSERT_EQ(&optree.root.children[1].children[1],
+            optree.instructions[add_ins.first_child + 1].node);
+  ASSERT_EQ(3, optree.max_depth);
+}
+
+TEST(optree_lowering, copy_points_to_own_tree) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(10);
+  operation::Int32Literal il2(20);
+  operation::Add add;
+
+  auto optree = std::make_shared<OpTree>(
+      OpTree({add, {{il1, {}}, {il2, {}}}}));
+  ASSERT_EQ(&optree->root, optree->instructions[0].node);
+  ASSERT_EQ(&optree->root.children[0], optree->instructions[1].node);
+
+  InterpretedProgram p(optree);
+  Interpreter i = p.get_instance();
+  ASSERT_EQ(ContinuationState::Ready, i.step());
+  ASSERT_EQ(ContinuationState::Ready, i.step());
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+  ASSERT_EQ(30, std::get<int32_t>(std::get<Value>(i.get_result())));
+}
+
+TEST(optree_lowering, instructions_carry_the_hooks_of_their_operation) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(10);
+  operation::WriteStaticOctets write("hello");
+  operation::OpSequence ops;
+
+  OpTree optree({ops, {{il1, {}}, {write, {}}}});
+  for (const auto &ins : optree.instructions) {
+    ASSERT_EQ(&FrameHooks::for_operation(*ins.operation), ins.frame_hooks);
+    ASSERT_EQ(&ContinuationHooks::for_operation(*ins.operation),
+              ins.continuation_hooks);
+  }
+  ASSERT_NE(optree.instructions[1].frame_hooks,
+            optree.instructions[2].frame_hooks);
+}
@@ -0,0 +1,109 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/optree.hpp>
+#include <networkprotocoldsl/trace.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(trace, ring_buffer_keeps_latest_entries) {
+  using namespace networkprotocoldsl;
+
+  auto ring = std::make_unique<trace::TraceRingBuffer>();
+  ASSERT_EQ(0, ring->snapshot().size());
+
+  for (size_t i = 0; i < trace::TraceRingBuffer::capacity + 10; i++) {
+    ring->record(3, i % 5);
+  }
+  auto entries = ring->snapshot();
+  ASSERT_EQ(trace::TraceRingBuffer::capacity, entries.size());
+  ASSERT_EQ(10, entries.front().sequence);
+  ASSERT_EQ(trace::TraceRingBuffer::capacity + 9, entries.back().sequence);
+  ASSERT_EQ(3, entries.back().tag);
+  ASSERT_EQ((trace::TraceRingBuffer::capacity + 9) % 5,
+            entries.back().operation_index);
+
+  ring->clear();
+  ASSERT_EQ(0, ring->snapshot().size());
+}
+
+TEST(trace, concurrent_writers) {
+  using namespace networkprotocoldsl;
+
+  auto ring = std::make_unique<trace::TraceRingBuffer>();
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; t++) {
+    writers.emplace_back([&ring, t]() {
+      for (int i = 0; i < 1000; i++) {
+        ring->record(t, i);
+      }
+    });
+  }
+  for (auto &w : writers) {
+    w.join();
+  }
+  auto entries = ring->snapshot();
+  ASSERT_EQ(4000, entries.size());
+  for (const auto &e : entries) {
+    ASSERT_GE(e.tag, 0);
+    ASSERT_LT(e.tag, 4);
+    ASSERT_LT(e.operation_index, 1000);
+  }
+}
+
+TEST(trace, enable_per_tag) {
+  using namespace networkprotocoldsl;
+
+  ASSERT_FALSE(trace::is_enabled(42));
+  trace::enable(42);
+  ASSERT_TRUE(trace::is_enabled(42));
+  ASSERT_FALSE(trace::is_enabled(43));
+  trace::disable(42);
+  ASSERT_FALSE(trace::is_enabled(42));
+
+  trace::enable(-1);
+  ASSERT_FALSE(trace::is_enabled(-1));
+  trace::enable(trace::max_tag);
+  ASSERT_FALSE(trace::is_enabled(trace::max_tag));
+}
+
+TEST(trace, interpreter_records_when_enabled) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(10);
+  operation::Int32Literal il2(20);
+  operation::Add add;
+  auto optree =
+      std::make_shared<OpTree>(OpTree({add, {{il1, {}}, {il2, {}}}}));
+
+  trace::buffer().clear();
+  InterpretedProgram p(optree);
+  Interpreter untraced = p.get_instance();
+  untraced.set_trace_tag(7);
+  while (untraced.step() != ContinuationState::Exited) {
+  }
+  ASSERT_EQ(0, trace::buffer().snapshot().size());
+
+  trace::enable(7);
+  Interpreter traced = p.get_instance();
+  traced.set_trace_tag(7);
+  while (traced.step() != ContinuationState::Exited) {
+  }
+  trace::disable(7);
+
+  std::ostringstream os;
+  trace::dump(os);
+#ifdef NETWORKPROTOCOLDSL_ENABLE_TRACING
+  auto entries = trace::buffer().snapshot();
+  ASSERT_EQ(3, entries.size());
+  ASSERT_EQ(7, entries[0].tag);
+  ASSERT_EQ(Operation(add).index(), entries[2].operation_index);
+  ASSERT_NE(std::string::npos, os.str().find("Int32Literal"));
+  ASSERT_NE(std::string::npos, os.str().find("Add"));
+#else
+  ASSERT_EQ(0, trace::buffer().snapshot().size());
+  ASSERT_EQ("", os.str());
+#endif
+}
@@ -0,0 +1,71 @@
+#include <networkprotocoldsl/value.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+TEST(octets_storage, short_octets_are_inline) {
+  using namespace networkprotocoldsl;
+
+  value::Octets o("EHLO");
+  ASSERT_TRUE(o.data.is_inline());
+  ASSERT_EQ("EHLO", *o.data);
+  ASSERT_EQ(4, o.data->size());
+
+  value::Octets shared{std::make_shared<const std::string>("EHLO")};
+  ASSERT_TRUE(shared.data.is_inline());
+  ASSERT_EQ("EHLO", *shared.data);
+
+  Value v = o;
+  Value copy = v;
+  ASSERT_EQ("EHLO", *std::get<value::Octets>(copy).data);
+}
+
+TEST(octets_storage, long_octets_are_shared) {
+  using namespace networkprotocoldsl;
+
+  std::string payload(value::OctetsData::inline_capacity() + 1, 'x');
+  value::Octets o(payload);
+  ASSERT_FALSE(o.data.is_inline());
+  ASSERT_EQ(payload, *o.data);
+
+  value::Octets copy = o;
+  ASSERT_EQ(o.data.get(), copy.data.get());
+}
+
+TEST(octets_storage, default_is_empty_handle) {
+  using namespace networkprotocoldsl;
+
+  value::Octets o;
+  ASSERT_FALSE(o.data);
+  value::Octets e("");
+  ASSERT_TRUE(e.data);
+  ASSERT_EQ(0, e.data->length());
+}
+
+TEST(octets_storage, long_slices_keep_the_buffer) {
+  using namespace networkprotocoldsl;
+
+  std::string payload(value::OctetsData::inline_capacity() + 1, 'x');
+  auto buffer = std::make_shared<const std::string>("HEAD " + payload + "\r\n");
+  value::Octets o(buffer, 5, payload.size());
+  ASSERT_TRUE(o.data.is_slice());
+  ASSERT_EQ(buffer->data() + 5, o.data.view().data());
+  ASSERT_EQ(payload, o.data.view());
+
+  value::Octets copy = o;
+  ASSERT_EQ(o.data.view().data(), copy.data.view().data());
+  // asking for a string copies the slice once.
+  ASSERT_EQ(payload, *copy.data);
+  ASSERT_EQ(o.data.get(), copy.data.get());
+}
+
+TEST(octets_storage, short_slices_are_inline) {
+  using namespace networkprotocoldsl;
+
+  auto buffer = std::make_shared<const std::string>("HELO example.com\r\n");
+  value::Octets o(buffer, 5, 11);
+  ASSERT_TRUE(o.data.is_inline());
+  ASSERT_EQ("example.com", *o.data);
+}
@@ -0,0 +1,79 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/lexicalpad.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(lexicalpad_slots, layout_puts_arguments_first) {
+  using namespace networkprotocoldsl;
+
+  operation::LexicalPadInitialize init_b("b");
+  operation::LexicalPadInitialize init_c("c");
+  operation::Int32Literal il1(1);
+  operation::OpSequence ops;
+
+  OpTree optree({ops, {{init_c, {{il1, {}}}}, {init_b, {{il1, {}}}}}});
+  auto layout = optree.pad_layout({"a", "b"});
+  ASSERT_EQ((LexicalPadLayout{"a", "b", "c"}), *layout);
+}
+
+TEST(lexicalpad_slots, slot_and_name_access_agree) {
+  using namespace networkprotocoldsl;
+
+  auto parent = std::make_shared<LexicalPad>();
+  parent->initialize("outer", int32_t(1));
+  auto layout = std::make_shared<const LexicalPadLayout>(
+      LexicalPadLayout{"a", "outer"});
+  LexicalPad pad(parent, layout);
+  pad.initialize(0, int32_t(10));
+
+  ASSERT_EQ(10, std::get<int32_t>(pad.get(LexicalPadSlot{0, 0}, "a")));
+  ASSERT_EQ(10, std::get<int32_t>(pad.get("a")));
+  // an uninitialized slot falls back to the parent, like a missing name.
+  ASSERT_EQ(1, std::get<int32_t>(pad.get(LexicalPadSlot{0, 1}, "outer")));
+  ASSERT_EQ(1, std::get<int32_t>(pad.get("outer")));
+
+  ASSERT_EQ(10, std::get<int32_t>(pad.set(LexicalPadSlot{0, 0}, "a",
+                                          int32_t(20))));
+  ASSERT_EQ(20, std::get<int32_t>(pad.get("a")));
+
+  // names outside of the layout still work and show up in the dict.
+  pad.initialize("extra", int32_t(30));
+  ASSERT_EQ(30, std::get<int32_t>(pad.get("extra")));
+  auto dict = std::get<value::Dictionary>(pad.as_dict());
+  ASSERT_EQ(2, dict.members->size());
+  ASSERT_EQ(20, std::get<int32_t>(dict.members->at("a")));
+  ASSERT_EQ(30, std::get<int32_t>(dict.members->at("extra")));
+}
+
+TEST(lexicalpad_slots, resolved_operations_in_a_callable) {
+  using namespace networkprotocoldsl;
+
+  operation::LexicalPadGet get_a("a", {0, 0});
+  operation::LexicalPadGet get_b("b", {0, 1});
+  operation::LexicalPadGet get_c("c", {0, 2});
+  operation::LexicalPadInitialize init_c("c", {0, 2});
+  operation::LexicalPadSet set_c("c", {0, 2});
+  operation::Add add;
+  operation::OpSequence ops;
+  operation::FunctionCall func;
+  operation::DynamicList dynlist;
+  operation::Int32Literal il2(2);
+  operation::Int32Literal il3(3);
+
+  auto callee_optree = std::make_shared<OpTree>(
+      OpTree({ops,
+              {{init_c, {{add, {{get_a, {}}, {get_b, {}}}}}},
+               {set_c, {{add, {{get_c, {}}, {get_c, {}}}}}},
+               {get_c, {}}}}));
+  operation::StaticCallable callee(callee_optree, {"a", "b"}, false);
+
+  auto main_optree = std::make_shared<OpTree>(OpTree(
+      {func, {{callee, {}}, {dynlist, {{il2, {}}, {il3, {}}}}}}));
+
+  InterpretedProgram p(main_optree);
+  Interpreter i1 = p.get_instance();
+  while (i1.step() != ContinuationState::Exited) {
+  }
+  ASSERT_EQ(10, std::get<int32_t>(std::get<Value>(i1.get_result())));
+}
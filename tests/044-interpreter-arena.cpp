@@ -0,0 +1,104 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/optree.hpp>
+#include <networkprotocoldsl/support/arena.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+
+static std::atomic<bool> counting_allocations = false;
+static std::atomic<std::size_t> allocations = 0;
+
+void *operator new(std::size_t n) {
+  if (counting_allocations.load()) {
+    allocations++;
+  }
+  void *p = std::malloc(n ? n : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+TEST(interpreter_arena, reuses_released_blocks) {
+  using namespace networkprotocoldsl;
+
+  support::Arena arena;
+  void *a = arena.allocate(40, 8);
+  void *b = arena.allocate(40, 8);
+  ASSERT_NE(a, b);
+  ASSERT_EQ(2, arena.in_use());
+  arena.deallocate(a, 40, 8);
+  ASSERT_EQ(a, arena.allocate(33, 8));
+  arena.deallocate(a, 33, 8);
+  arena.deallocate(b, 40, 8);
+  ASSERT_EQ(0, arena.in_use());
+  ASSERT_EQ(1, arena.chunk_count());
+
+  arena.reset();
+  ASSERT_EQ(a, arena.allocate(40, 8));
+  arena.deallocate(a, 40, 8);
+  ASSERT_EQ(1, arena.chunk_count());
+}
+
+TEST(interpreter_arena, large_blocks_bypass_the_arena) {
+  using namespace networkprotocoldsl;
+
+  support::Arena arena;
+  void *p = arena.allocate(1024 * 1024, 8);
+  ASSERT_EQ(0, arena.in_use());
+  ASSERT_EQ(0, arena.chunk_count());
+  arena.deallocate(p, 1024 * 1024, 8);
+}
+
+static std::size_t allocations_while_calling(int calls) {
+  using namespace networkprotocoldsl;
+
+  operation::LexicalPadInitialize init_x("x", {0, 0});
+  operation::LexicalPadGet get_x("x", {0, 0});
+  operation::LexicalPadSet set_x("x", {0, 0});
+  operation::Int32Literal il1(1);
+  operation::Int32Literal il2(2);
+  operation::Add add;
+  operation::OpSequence ops;
+  operation::FunctionCall func;
+  operation::DynamicList dynlist;
+
+  auto callee_optree = std::make_shared<OpTree>(
+      OpTree({ops,
+              {{init_x, {{il1, {}}}},
+               {set_x, {{add, {{get_x, {}}, {il2, {}}}}}},
+               {get_x, {}}}}));
+  operation::StaticCallable callee(callee_optree, {}, true);
+
+  std::vector<OpTreeNode> body;
+  for (int i = 0; i < calls; i++) {
+    body.push_back({func, {{callee, {}}, {dynlist, {}}}});
+  }
+  auto main_optree = std::make_shared<OpTree>(OpTree({ops, body}));
+
+  InterpretedProgram p(main_optree);
+  Interpreter i1 = p.get_instance();
+  allocations = 0;
+  counting_allocations = true;
+  while (i1.step() != ContinuationState::Exited) {
+  }
+  counting_allocations = false;
+  EXPECT_EQ(3, std::get<int32_t>(std::get<Value>(i1.get_result())));
+  return allocations.load();
+}
+
+TEST(interpreter_arena, calls_in_steady_state_do_not_allocate) {
+  // a first run initializes anything static along the way.
+  allocations_while_calling(1);
+  // the first call warms up the arena and the continuation stack,
+  // every call after that must reuse what is already there.
+  std::size_t one_call = allocations_while_calling(1);
+  std::size_t many_calls = allocations_while_calling(50);
+  ASSERT_EQ(one_call, many_calls);
+}
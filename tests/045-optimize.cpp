@@ -0,0 +1,113 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/optimize.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(optimize, folds_arithmetic_over_literals) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(1);
+  operation::Int32Literal il2(2);
+  operation::Int32Literal il3(3);
+  operation::Add add;
+  operation::Multiply mul;
+
+  auto optree = std::make_shared<const OpTree>(
+      OpTree({add, {{il1, {}}, {mul, {{il2, {}}, {il3, {}}}}}}));
+  auto optimized = optimize(optree);
+  ASSERT_EQ(1, optimized->instructions.size());
+  const auto *literal =
+      std::get_if<operation::Int32Literal>(&optimized->root.operation);
+  ASSERT_NE(nullptr, literal);
+  ASSERT_EQ(7, std::get<int32_t>((*literal)({})));
+}
+
+TEST(optimize, keeps_only_the_branch_taken) {
+  using namespace networkprotocoldsl;
+
+  operation::Int32Literal il1(1);
+  operation::Int32Literal il10(10);
+  operation::Int32Literal il20(20);
+  operation::Eq eq;
+  operation::If op_if;
+  operation::StaticCallable then_callable(
+      std::make_shared<OpTree>(OpTree({il10, {}})));
+  operation::StaticCallable else_callable(
+      std::make_shared<OpTree>(OpTree({il20, {}})));
+
+  auto optree = std::make_shared<const OpTree>(OpTree(
+      {op_if,
+       {{eq, {{il1, {}}, {il1, {}}}}, {then_callable, {}}, {else_callable, {}}}}));
+  auto optimized = optimize(optree);
+  ASSERT_TRUE(
+      std::holds_alternative<operation::FunctionCall>(optimized->root.operation));
+  ASSERT_LT(optimized->instructions.size(), optree->instructions.size());
+
+  InterpretedProgram p(optimized);
+  Interpreter i1 = p.get_instance();
+  while (i1.step() != ContinuationState::Exited) {
+  }
+  ASSERT_EQ(10, std::get<int32_t>(std::get<Value>(i1.get_result())));
+}
+
+TEST(optimize, merges_static_writes_across_nested_sequences) {
+  using namespace networkprotocoldsl;
+
+  operation::OpSequence ops;
+  operation::WriteStaticOctets write_get("GET ");
+  operation::WriteStaticOctets write_space(" ");
+  operation::WriteStaticOctets write_crlf("\r\n");
+  operation::WriteOctets write_octets;
+  operation::IntToAscii int_to_ascii;
+  operation::Int32Literal il42(42);
+
+  auto optree = std::make_shared<const OpTree>(
+      OpTree({ops,
+              {{write_get, {}},
+               {ops,
+                {{write_octets, {{int_to_ascii, {{il42, {}}}}}},
+                 {write_space, {}}}},
+               {write_crlf, {}}}}));
+  auto optimized = optimize(optree);
+  ASSERT_EQ(1, optimized->instructions.size());
+  const auto *write = std::get_if<operation::WriteStaticOctets>(
+      &optimized->root.operation);
+  ASSERT_NE(nullptr, write);
+  ASSERT_EQ("GET 42 \r\n", write->get_contents());
+
+  InterpretedProgram p(optimized);
+  Interpreter i1 = p.get_instance();
+  ASSERT_EQ(ContinuationState::Blocked, i1.step());
+  ASSERT_EQ(ReasonForBlockedOperation::WaitingForWrite,
+            std::get<ReasonForBlockedOperation>(i1.get_result()));
+  auto buf = i1.get_write_buffer();
+  ASSERT_EQ("GET 42 \r\n", buf);
+  i1.handle_write(buf.length());
+  ASSERT_EQ(ContinuationState::Exited, i1.step());
+}
+
+TEST(optimize, keeps_the_layout_of_the_lexical_pads) {
+  using namespace networkprotocoldsl;
+
+  operation::OpSequence ops;
+  operation::LexicalPadInitialize init_a("a");
+  operation::LexicalPadInitialize init_b("b");
+  operation::LexicalPadInitialize init_c("c");
+  operation::Int32Literal il1(1);
+  operation::WriteStaticOctets write_x("x");
+
+  auto callee_optree = std::make_shared<OpTree>(
+      OpTree({ops,
+              {{ops, {{init_a, {{il1, {}}}}, {ops, {{init_b, {{il1, {}}}}}}}},
+               {write_x, {}},
+               {init_c, {{il1, {}}}}}}));
+  operation::StaticCallable callee(callee_optree, {"b"}, true);
+  auto optree = std::make_shared<const OpTree>(OpTree({callee, {}}));
+
+  auto optimized = optimize(optree);
+  const auto &optimized_callee =
+      std::get<operation::StaticCallable>(optimized->root.operation);
+  ASSERT_EQ(*callee_optree->pad_layout({"b"}),
+            *optimized_callee.get_optree()->pad_layout({"b"}));
+}
@@ -0,0 +1,123 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+using namespace networkprotocoldsl;
+
+static int32_t run(Interpreter &i, std::size_t &max_depth) {
+  max_depth = i.stack_depth();
+  while (i.step() != ContinuationState::Exited) {
+    max_depth = std::max(max_depth, i.stack_depth());
+  }
+  return std::get<int32_t>(std::get<Value>(i.get_result()));
+}
+
+TEST(interpreter_tail_calls, recursion_in_tail_position_does_not_grow) {
+  const int32_t iterations = 100000;
+
+  operation::OpSequence ops;
+  operation::FunctionCall func;
+  operation::DynamicList dynlist;
+  operation::If op_if;
+  operation::LesserEqual le;
+  operation::Add add;
+  operation::Int32Literal il0(0);
+  operation::Int32Literal il1(1);
+  operation::Int32Literal il_last(iterations - 1);
+  operation::LexicalPadGet get_n("n");
+  operation::LexicalPadGet get_loop("loop");
+  operation::LexicalPadInitializeGlobal init_loop("loop");
+
+  // loop(n): if n <= iterations - 1 then loop(n + 1) else n
+  operation::StaticCallable recurse(
+      std::make_shared<OpTree>(OpTree(
+          {func,
+           {{get_loop, {}}, {dynlist, {{add, {{get_n, {}}, {il1, {}}}}}}}})));
+  operation::StaticCallable done(
+      std::make_shared<OpTree>(OpTree({get_n, {}})));
+  operation::StaticCallable loop(
+      std::make_shared<OpTree>(OpTree(
+          {op_if,
+           {{le, {{get_n, {}}, {il_last, {}}}}, {recurse, {}}, {done, {}}}})),
+      {"n"}, false);
+
+  auto optree = std::make_shared<OpTree>(
+      OpTree({ops,
+              {{init_loop, {{loop, {}}}},
+               {func, {{get_loop, {}}, {dynlist, {{il0, {}}}}}}}}));
+  InterpretedProgram p(optree);
+  Interpreter i = p.get_instance();
+
+  std::size_t max_depth;
+  ASSERT_EQ(iterations, run(i, max_depth));
+  // the root continuation and the one running the current call.
+  ASSERT_EQ(2, max_depth);
+}
+
+TEST(interpreter_tail_calls, state_machine_transitions_run_in_constant_depth) {
+  const int32_t transitions = 1000000;
+
+  operation::OpSequence ops;
+  operation::DynamicList dynlist;
+  operation::If op_if;
+  operation::LesserEqual le;
+  operation::Add add;
+  operation::IntToAscii int_to_ascii;
+  operation::DictionaryInitialize dict_init;
+  operation::Int32Literal il0(0);
+  operation::Int32Literal il1(1);
+  operation::Int32Literal il_last(transitions - 1);
+  operation::LexicalPadGet get_count("count");
+  operation::LexicalPadGet get_dictionary("dictionary");
+  operation::LexicalPadGet get_again("again");
+  operation::LexicalPadGet get_close("close");
+  operation::LexicalPadInitialize init_count("count");
+  operation::LexicalPadInitialize init_again("again");
+  operation::LexicalPadInitialize init_close("close");
+  operation::LexicalPadSet set_count("count");
+
+  // the state callback picks transition "1" to loop back and "0" to
+  // close, there is no octets literal to name them otherwise. The
+  // names are made once, so the transitions do as little as possible
+  // besides invoking the callbacks.
+  operation::StaticCallable again(std::make_shared<OpTree>(
+      OpTree({dynlist, {{get_again, {}}, {get_dictionary, {}}}})));
+  operation::StaticCallable close(std::make_shared<OpTree>(
+      OpTree({dynlist, {{get_close, {}}, {get_dictionary, {}}}})));
+  auto open_callback = std::make_shared<const OpTree>(
+      OpTree({op_if,
+              {{le, {{get_count, {}}, {il_last, {}}}},
+               {again, {}},
+               {close, {}}}}));
+  auto closed_callback = std::make_shared<const OpTree>(
+      OpTree({dynlist, {{get_close, {}}, {get_dictionary, {}}}}));
+  auto count_transition = std::make_shared<const OpTree>(
+      OpTree({ops,
+              {{set_count, {{add, {{get_count, {}}, {il1, {}}}}}},
+               {dynlist, {{dict_init, {}}}}}}));
+  auto close_transition =
+      std::make_shared<const OpTree>(OpTree({dynlist, {{dict_init, {}}}}));
+
+  operation::StateMachineOperation::StateMap states;
+  states["Open"].callback_optree = open_callback;
+  states["Open"].transitions["1"] = {count_transition, {}, "Open"};
+  states["Open"].transitions["0"] = {close_transition, {}, "Closed"};
+  states["Closed"].callback_optree = closed_callback;
+  operation::StateMachineOperation state_machine(states);
+
+  auto optree = std::make_shared<OpTree>(
+      OpTree({ops,
+              {{init_count, {{il0, {}}}},
+               {init_again, {{int_to_ascii, {{il1, {}}}}}},
+               {init_close, {{int_to_ascii, {{il0, {}}}}}},
+               {state_machine, {}},
+               {get_count, {}}}}));
+  InterpretedProgram p(optree);
+  Interpreter i = p.get_instance();
+
+  std::size_t max_depth;
+  ASSERT_EQ(transitions, run(i, max_depth));
+  ASSERT_EQ(2, max_depth);
+}
@@ -0,0 +1,100 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/dynamiclist.hpp>
+#include <networkprotocoldsl/operation/functioncall.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <future>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testlibs/http_message_optrees.hpp"
+
+using namespace networkprotocoldsl;
+
+static InterpretedProgram echo_request_program() {
+  operation::FunctionCall function_call;
+  operation::DynamicList dynamic_list;
+  return InterpretedProgram(std::make_shared<OpTree>(
+      OpTree({{function_call,
+               {{testlibs::get_write_request_callable(), {}},
+                {function_call,
+                 {{testlibs::get_read_request_callable(), {}},
+                  {dynamic_list, {}}}}}}})));
+}
+
+/**
+ * Runs one request through each of the connections with the given
+ * number of workers. With `same_shard` all of them go to the queues of
+ * the first worker once they are scheduled again, so the others only
+ * get to them by stealing. Each interpreter is run for at most
+ * `quantum` steps at a time.
+ */
+static void run_connections(std::size_t workers, int connections,
+                            bool same_shard, std::size_t quantum = 256) {
+  std::string input = "GET /foo/bar/baz HTTP/1.1\r\n"
+                      "Accept: application/json\r\n"
+                      "Host: Test Value\r\n"
+                      "\r\n";
+  InterpretedProgram p = echo_request_program();
+  InterpreterCollectionManager mgr;
+  std::vector<std::future<Value>> results;
+  for (int c = 0; c < connections; c++) {
+    results.push_back(mgr.insert_interpreter(c, p));
+    auto context = mgr.get_collection()->interpreters.at(c);
+    if (same_shard) {
+      context->shard = 0;
+    }
+    // split the request so the interpreters block on reads as well.
+    context->input_buffer.push_back(input.substr(0, 10));
+    context->input_buffer.push_back(input.substr(10));
+  }
+
+  InterpreterRunner runner;
+  runner.exit_when_done = true;
+  runner.steps_per_quantum = quantum;
+  std::vector<std::thread> threads;
+  for (std::size_t w = 0; w < workers; w++) {
+    threads.emplace_back([&runner, &mgr, w, workers] {
+      runner.interpreter_loop(mgr, w, workers);
+    });
+  }
+  for (auto &result : results) {
+    result.wait();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (const auto &[fd, context] : mgr.get_collection()->interpreters) {
+    ASSERT_TRUE(context->exited.load());
+    std::string output;
+    while (auto buffer = context->output_buffer.pop()) {
+      output += buffer->data.view();
+    }
+    ASSERT_EQ(input, output);
+  }
+}
+
+TEST(interpreter_runner_workers, connections_are_spread_over_workers) {
+  run_connections(4, 200, false);
+}
+
+TEST(interpreter_runner_workers, idle_workers_steal_ready_interpreters) {
+  run_connections(4, 200, true);
+}
+
+TEST(interpreter_runner_workers, single_worker_runs_everything) {
+  run_connections(1, 50, false);
+}
+
+TEST(interpreter_runner_workers, single_step_quantum) {
+  run_connections(2, 50, false, 1);
+}
+
+TEST(interpreter_runner_workers, quantum_larger_than_the_program) {
+  run_connections(2, 50, false, 1000000);
+}
@@ -0,0 +1,95 @@
+#include <networkprotocoldsl/support/persistentmap.hpp>
+
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+
+using networkprotocoldsl::support::PersistentMap;
+
+template <typename Map>
+static std::map<int, std::string> contents(const Map &map) {
+  std::map<int, std::string> result;
+  for (const auto &[key, value] : map) {
+    EXPECT_TRUE(result.insert({key, value}).second);
+  }
+  EXPECT_EQ(map.size(), result.size());
+  return result;
+}
+
+TEST(persistent_map, insert_find_and_erase) {
+  PersistentMap<int, std::string> empty;
+  auto one = empty.with(1, "one");
+  auto two = one.with(2, "two");
+  auto replaced = two.with(1, "uno");
+  auto removed = replaced.without(2);
+
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ(empty.end(), empty.find(1));
+  ASSERT_EQ("one", one.at(1));
+  ASSERT_FALSE(one.contains(2));
+  ASSERT_EQ("two", two.at(2));
+  ASSERT_EQ("one", two.at(1));
+  ASSERT_EQ(2, replaced.size());
+  ASSERT_EQ("uno", replaced.find(1)->second);
+  ASSERT_EQ(1, removed.size());
+  ASSERT_EQ(removed.end(), removed.find(2));
+  ASSERT_EQ(1, removed.without(3).size());
+  ASSERT_THROW(removed.at(2), std::out_of_range);
+}
+
+TEST(persistent_map, older_versions_are_left_alone) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> keys(0, 5000);
+  PersistentMap<int, std::string> map;
+  std::map<int, std::string> expected;
+  std::vector<std::pair<PersistentMap<int, std::string>,
+                        std::map<int, std::string>>>
+      versions;
+  for (int i = 0; i < 20000; i++) {
+    int key = keys(random);
+    if (i % 3 == 2) {
+      map = map.without(key);
+      expected.erase(key);
+    } else {
+      map = map.with(key, std::to_string(i));
+      expected[key] = std::to_string(i);
+    }
+    if (i % 1000 == 0) {
+      versions.push_back({map, expected});
+    }
+  }
+  ASSERT_EQ(expected, contents(map));
+  for (const auto &[version, version_expected] : versions) {
+    ASSERT_EQ(version_expected, contents(version));
+    for (const auto &[key, value] : version_expected) {
+      ASSERT_EQ(value, version.at(key));
+    }
+  }
+}
+
+// Puts every key in one of two buckets, so they all collide.
+struct CollidingHash {
+  std::size_t operator()(int key) const { return key % 2; }
+};
+
+TEST(persistent_map, keys_with_the_same_hash) {
+  PersistentMap<int, int, CollidingHash> map;
+  for (int i = 0; i < 100; i++) {
+    map = map.with(i, i * 10);
+  }
+  ASSERT_EQ(100, map.size());
+  for (int i = 0; i < 100; i += 2) {
+    map = map.without(i);
+  }
+  ASSERT_EQ(50, map.size());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i % 2 == 1, map.contains(i));
+  }
+  int sum = 0;
+  for (const auto &[key, value] : map) {
+    sum += value;
+  }
+  ASSERT_EQ(25000, sum);
+}
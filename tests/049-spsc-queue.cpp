@@ -0,0 +1,44 @@
+#include <networkprotocoldsl/support/spscqueue.hpp>
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace networkprotocoldsl::support;
+
+TEST(spsc_queue, is_bounded) {
+  SpscQueue<int> queue(3);
+  ASSERT_EQ(4, queue.capacity());
+  ASSERT_TRUE(queue.empty());
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.try_push(i));
+  }
+  ASSERT_FALSE(queue.try_push(4));
+  ASSERT_EQ(0, queue.pop());
+  ASSERT_TRUE(queue.try_push(4));
+  for (int i = 1; i < 5; i++) {
+    ASSERT_EQ(i, queue.pop());
+  }
+  ASSERT_EQ(std::nullopt, queue.pop());
+  ASSERT_TRUE(queue.empty());
+}
+
+TEST(spsc_queue, keeps_the_order_across_threads) {
+  constexpr int count = 20000;
+  SpscQueue<std::string> queue(16);
+  std::thread producer([&queue] {
+    for (int i = 0; i < count; i++) {
+      queue.push_back(std::to_string(i));
+    }
+  });
+  for (int i = 0; i < count;) {
+    if (auto value = queue.pop()) {
+      ASSERT_EQ(std::to_string(i), *value);
+      i++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  ASSERT_EQ(std::nullopt, queue.pop());
+}
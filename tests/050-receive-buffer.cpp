@@ -0,0 +1,88 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/readstaticoctets.hpp>
+#include <networkprotocoldsl/optree.hpp>
+#include <networkprotocoldsl/support/receivebuffer.hpp>
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace networkprotocoldsl;
+
+TEST(receive_buffer, appends_after_what_was_not_consumed) {
+  support::ReceiveBuffer buffer;
+  ASSERT_TRUE(buffer.empty());
+  buffer.append("HELLO ");
+  buffer.append("WORLD");
+  ASSERT_EQ("HELLO WORLD", buffer.unconsumed());
+  buffer.consume(6);
+  ASSERT_EQ("WORLD", buffer.unconsumed());
+  ASSERT_EQ("WORLD",
+            std::string_view(*buffer.buffer()).substr(buffer.offset()));
+  buffer.append("!");
+  ASSERT_EQ("WORLD!", buffer.unconsumed());
+  buffer.consume(6);
+  ASSERT_TRUE(buffer.empty());
+}
+
+TEST(receive_buffer, reuses_the_storage_once_consumed) {
+  support::ReceiveBuffer buffer;
+  buffer.append("HELLO");
+  const std::string *storage = buffer.buffer().get();
+  buffer.consume(5);
+  buffer.append("WORLD");
+  ASSERT_EQ(storage, buffer.buffer().get());
+  ASSERT_EQ(0, buffer.offset());
+  ASSERT_EQ("WORLD", buffer.unconsumed());
+}
+
+TEST(receive_buffer, leaves_the_bytes_of_a_held_buffer_alone) {
+  support::ReceiveBuffer buffer;
+  buffer.append("HELLO");
+  auto held = buffer.buffer();
+  std::string_view slice(*held);
+  buffer.consume(5);
+  // more than fits in its capacity, so it has to move.
+  buffer.append(std::string(100000, 'x'));
+  ASSERT_EQ("HELLO", slice);
+  ASSERT_NE(held, buffer.buffer());
+  ASSERT_EQ(100000, buffer.size());
+}
+
+/**
+ * Feeds a message of the given size to an interpreter one byte per
+ * read, while the interpreter waits for the whole message, and
+ * returns how long it took.
+ */
+static std::chrono::duration<double>
+read_message_a_byte_at_a_time(std::size_t size) {
+  operation::ReadStaticOctets read_message(std::string(size, 'x'));
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({read_message, {}})));
+  InterpreterCollectionManager mgr;
+  auto result = mgr.insert_interpreter(0, p);
+  InterpreterRunner runner;
+  runner.exit_when_done = true;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  auto collection = mgr.get_collection();
+  auto context = collection->interpreters.at(0);
+  for (std::size_t i = 0; i < size; i++) {
+    context->input_buffer.push_back("x");
+    collection->signals->schedule(context);
+  }
+  EXPECT_EQ(true, std::get<bool>(result.get()));
+  worker.join();
+  return std::chrono::steady_clock::now() - start;
+}
+
+TEST(receive_buffer, byte_at_a_time_reads_take_linear_time) {
+  auto small = read_message_a_byte_at_a_time(256 * 1024);
+  auto large = read_message_a_byte_at_a_time(1024 * 1024);
+  // four times the bytes; joining the buffers again on every read
+  // would make it sixteen times slower.
+  ASSERT_LT(large.count(), 8 * small.count());
+}
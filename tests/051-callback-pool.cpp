@@ -0,0 +1,137 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/opsequence.hpp>
+#include <networkprotocoldsl/operation/unarycallback.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace networkprotocoldsl;
+
+/**
+ * Every connection runs a callback that takes a while, and then a
+ * second one, while keeping track of how many run at the same time.
+ * The argument of each callback is the connection times ten plus
+ * which of the two it is.
+ */
+struct CallbackPoolRun {
+  struct Event {
+    int32_t connection;
+    int32_t sequence;
+    bool finished;
+  };
+
+  std::atomic<int> running = 0;
+  std::atomic<int> most_running = 0;
+  std::mutex mtx;
+  // callbacks starting and finishing, in the order they did.
+  std::vector<Event> events;
+
+  void record(int32_t arg, bool finished) {
+    std::lock_guard<std::mutex> lk(mtx);
+    events.push_back({arg / 10, arg % 10, finished});
+  }
+
+  Value work(const std::vector<Value> &args) {
+    int now = ++running;
+    int most = most_running.load();
+    while (now > most && !most_running.compare_exchange_weak(most, now)) {
+    }
+    record(std::get<int32_t>(args[0]), false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    running--;
+    record(std::get<int32_t>(args[0]), true);
+    return args[0];
+  }
+
+  std::size_t started(int32_t sequence) {
+    return std::count_if(events.begin(), events.end(),
+                         [sequence](const Event &e) {
+                           return !e.finished && e.sequence == sequence;
+                         });
+  }
+
+  // Each connection started its second callback only after its first
+  // one finished.
+  void assert_in_order(int connections) {
+    for (int32_t c = 0; c < connections; c++) {
+      auto at = [this, c](int32_t sequence, bool finished) {
+        return std::find_if(events.begin(), events.end(),
+                            [=](const Event &e) {
+                              return e.connection == c &&
+                                     e.sequence == sequence &&
+                                     e.finished == finished;
+                            });
+      };
+      auto first_finished = at(1, true);
+      auto second_started = at(2, false);
+      ASSERT_NE(events.end(), first_finished);
+      ASSERT_NE(events.end(), second_started);
+      ASSERT_LT(first_finished, second_started);
+    }
+  }
+
+  void run(std::size_t threads, std::size_t max_pending, int connections) {
+    operation::OpSequence ops;
+    operation::UnaryCallback callback("work");
+
+    InterpreterCollectionManager mgr;
+    std::vector<std::future<Value>> results;
+    for (int c = 0; c < connections; c++) {
+      operation::Int32Literal first(c * 10 + 1);
+      operation::Int32Literal second(c * 10 + 2);
+      InterpretedProgram p(std::make_shared<OpTree>(
+          OpTree({ops,
+                  {{callback, {{first, {}}}}, {callback, {{second, {}}}}}})));
+      results.push_back(mgr.insert_interpreter(c, p));
+    }
+    InterpreterRunner runner;
+    runner.callbacks.emplace(
+        "work", [this](const std::vector<Value> &args) { return work(args); });
+    runner.exit_when_done = true;
+    runner.callback_threads = threads;
+    runner.max_pending_callbacks = max_pending;
+    std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+    std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+    for (int c = 0; c < connections; c++) {
+      ASSERT_EQ(c * 10 + 2, std::get<int32_t>(results[c].get()));
+    }
+    worker.join();
+    callbacks.join();
+  }
+};
+
+TEST(callback_pool, runs_callbacks_of_different_connections_together) {
+  CallbackPoolRun run;
+  run.run(4, 1024, 16);
+  ASSERT_EQ(64, run.events.size());
+  ASSERT_GT(run.most_running.load(), 1);
+  ASSERT_LE(run.most_running.load(), 4);
+  run.assert_in_order(16);
+}
+
+TEST(callback_pool, single_thread_runs_one_at_a_time) {
+  CallbackPoolRun run;
+  run.run(1, 1024, 8);
+  ASSERT_EQ(32, run.events.size());
+  ASSERT_EQ(1, run.most_running.load());
+}
+
+TEST(callback_pool, limits_the_callbacks_in_flight) {
+  CallbackPoolRun run;
+  run.run(4, 2, 16);
+  ASSERT_EQ(64, run.events.size());
+  ASSERT_LE(run.most_running.load(), 2);
+  ASSERT_EQ(16, run.started(1));
+  ASSERT_EQ(16, run.started(2));
+  run.assert_in_order(16);
+}
@@ -0,0 +1,107 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/unarycallback.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace networkprotocoldsl;
+
+/**
+ * Every connection runs one asynchronous callback, whose completions
+ * are kept aside until all of them started, and then handed to
+ * finish.
+ */
+struct AsyncCallbackRun {
+  std::mutex mtx;
+  std::vector<std::pair<int32_t, CallbackCompletion>> started;
+  std::promise<void> all_started;
+
+  std::vector<Value>
+  run(int connections,
+      std::function<void(std::vector<std::pair<int32_t, CallbackCompletion>>)>
+          finish) {
+    operation::UnaryCallback callback("work");
+    InterpretedProgram p(std::make_shared<OpTree>(
+        OpTree({callback, {{operation::Int32Literal(21), {}}}})));
+
+    InterpreterCollectionManager mgr;
+    std::vector<std::future<Value>> results;
+    for (int c = 0; c < connections; c++) {
+      results.push_back(mgr.insert_interpreter(c, p));
+    }
+    InterpreterRunner runner;
+    runner.async_callbacks.emplace(
+        "work", [this, connections](const std::vector<Value> &args,
+                                    CallbackCompletion done) {
+          std::lock_guard<std::mutex> lk(mtx);
+          started.emplace_back(std::get<int32_t>(args[0]), std::move(done));
+          if (started.size() == static_cast<std::size_t>(connections)) {
+            all_started.set_value();
+          }
+        });
+    runner.exit_when_done = true;
+    std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+    std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+    // nothing finishes until every callback started, which a single
+    // callback thread can only do if it doesn't wait for them.
+    all_started.get_future().wait();
+    std::thread finisher([this, &finish] {
+      std::vector<std::pair<int32_t, CallbackCompletion>> handles;
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        handles.swap(started);
+      }
+      finish(std::move(handles));
+    });
+    std::vector<Value> out;
+    for (auto &result : results) {
+      out.push_back(result.get());
+    }
+    finisher.join();
+    worker.join();
+    callbacks.join();
+    return out;
+  }
+};
+
+TEST(async_callbacks, keeps_many_in_flight_on_one_thread) {
+  AsyncCallbackRun run;
+  auto results = run.run(1000, [](auto handles) {
+    for (auto &[arg, done] : handles) {
+      done(arg * 2);
+    }
+  });
+  ASSERT_EQ(1000, results.size());
+  for (const auto &v : results) {
+    ASSERT_EQ(42, std::get<int32_t>(v));
+  }
+}
+
+TEST(async_callbacks, only_the_first_completion_counts) {
+  AsyncCallbackRun run;
+  auto results = run.run(4, [](auto handles) {
+    for (auto &[arg, done] : handles) {
+      CallbackCompletion copy = done;
+      copy(arg);
+      done(arg * 2);
+    }
+  });
+  for (const auto &v : results) {
+    ASSERT_EQ(21, std::get<int32_t>(v));
+  }
+}
+
+TEST(async_callbacks, dropped_completion_is_an_error) {
+  AsyncCallbackRun run;
+  auto results = run.run(4, [](auto handles) { handles.clear(); });
+  for (const auto &v : results) {
+    ASSERT_EQ(value::RuntimeError::TypeError, std::get<value::RuntimeError>(v));
+  }
+}
@@ -0,0 +1,101 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/readoctetsuntilterminator.hpp>
+#include <networkprotocoldsl/optree.hpp>
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace networkprotocoldsl;
+
+TEST(read_until_terminator_chunks, consumes_what_cannot_start_a_terminator) {
+  operation::ReadOctetsUntilTerminator read_data("\r\n.\r\n");
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({read_data, {}})));
+  Interpreter i = p.get_instance();
+
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  // the last four bytes may be the start of the terminator.
+  ASSERT_EQ(4, i.handle_read("hello\r\n."));
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(0, i.handle_read("o\r\n."));
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(6, i.handle_read("o\r\n.\r\nMAIL"));
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+  ASSERT_EQ("hello",
+            *(std::get<value::Octets>(std::get<Value>(i.get_result())).data));
+}
+
+TEST(read_until_terminator_chunks, escape_cut_between_reads) {
+  operation::ReadOctetsUntilTerminator read_header("\r\n", "\n", "\r\n ");
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({read_header, {}})));
+  Interpreter i = p.get_instance();
+
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(3, i.handle_read("text\r"));
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(6, i.handle_read("t\r\n more"));
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  ASSERT_EQ(4, i.handle_read("re\r\n"));
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+  ASSERT_EQ("text\nmore",
+            *(std::get<value::Octets>(std::get<Value>(i.get_result())).data));
+}
+
+/**
+ * Feeds a value of the given size, made of short lines, through the
+ * runner in chunks of a kilobyte, and checks it came out whole.
+ */
+static std::chrono::duration<double>
+read_in_chunks(const operation::ReadOctetsUntilTerminator &read,
+               std::size_t size) {
+  const std::string line = "0123456789abcdef0123456789abcde\r\n";
+  std::string data;
+  data.reserve(size + 5);
+  while (data.size() + line.size() <= size) {
+    data += line;
+  }
+  std::string wire = data + ".\r\n";
+
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({read, {}})));
+  InterpreterCollectionManager mgr;
+  auto result = mgr.insert_interpreter(0, p);
+  InterpreterRunner runner;
+  runner.exit_when_done = true;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  auto collection = mgr.get_collection();
+  auto context = collection->interpreters.at(0);
+  for (std::size_t offset = 0; offset < wire.size(); offset += 1024) {
+    context->input_buffer.push_back(wire.substr(offset, 1024));
+    collection->signals->schedule(context);
+  }
+  auto value = result.get();
+  worker.join();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  // the terminator takes the line break of the last line with it.
+  EXPECT_EQ(data.substr(0, data.size() - 2),
+            *(std::get<value::Octets>(value).data));
+  return elapsed;
+}
+
+TEST(read_until_terminator_chunks, ten_megabytes_take_linear_time) {
+  operation::ReadOctetsUntilTerminator read_data("\r\n.\r\n");
+  auto small = read_in_chunks(read_data, 10 * 1024 * 1024 / 4);
+  auto large = read_in_chunks(read_data, 10 * 1024 * 1024);
+  // four times the bytes; scanning from the start on every read would
+  // make it sixteen times slower.
+  ASSERT_LT(large.count(), 8 * small.count());
+}
+
+TEST(read_until_terminator_chunks, escaped_ten_megabytes_take_linear_time) {
+  // nothing in the data is escaped, but both patterns are searched.
+  operation::ReadOctetsUntilTerminator read_data("\r\n.\r\n", "\r\n",
+                                                 "\r\n..");
+  auto small = read_in_chunks(read_data, 10 * 1024 * 1024 / 4);
+  auto large = read_in_chunks(read_data, 10 * 1024 * 1024);
+  ASSERT_LT(large.count(), 8 * small.count());
+}
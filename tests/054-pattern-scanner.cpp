@@ -0,0 +1,113 @@
+#include <networkprotocoldsl/support/patternscanner.hpp>
+
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using networkprotocoldsl::support::PatternScanner;
+
+static std::vector<PatternScanner::Implementation> supported_implementations() {
+  std::vector<PatternScanner::Implementation> out;
+  for (auto i :
+       {PatternScanner::Implementation::Scalar,
+        PatternScanner::Implementation::SSE2,
+        PatternScanner::Implementation::AVX2}) {
+    if (PatternScanner::supported(i)) {
+      out.push_back(i);
+    }
+  }
+  return out;
+}
+
+// the earliest match the slow way, first pattern winning ties.
+static PatternScanner::Match reference_find(const std::vector<std::string> &p,
+                                            std::string_view in,
+                                            std::size_t from) {
+  for (std::size_t pos = from; pos < in.size(); pos++) {
+    for (std::size_t i = 0; i < p.size(); i++) {
+      if (in.substr(pos).starts_with(p[i])) {
+        return {pos, i};
+      }
+    }
+  }
+  return {};
+}
+
+TEST(pattern_scanner, finds_the_earliest_pattern) {
+  for (auto impl : supported_implementations()) {
+    PatternScanner scanner({"\r\n ", "\r\n"}, impl);
+    auto m = scanner.find("Content-Type: text/plain;\r\n charset=utf-8\r\n");
+    ASSERT_EQ(25, m.position);
+    ASSERT_EQ(0, m.pattern);
+    m = scanner.find("Content-Type: text/plain;\r\n charset=utf-8\r\n", 28);
+    ASSERT_EQ(41, m.position);
+    ASSERT_EQ(1, m.pattern);
+    // a pattern cut at the end of the input is not a match.
+    m = scanner.find("Subject: hi\r");
+    ASSERT_EQ(PatternScanner::npos, m.position);
+  }
+}
+
+TEST(pattern_scanner, agrees_with_a_naive_search) {
+  const std::vector<std::string> patterns = {"\r\n.\r\n", "\r\n..", "\r\n",
+                                             "ab"};
+  std::mt19937 rng(42);
+  const std::string alphabet = "\r\n.ab x";
+  for (int round = 0; round < 200; round++) {
+    std::string in(rng() % 300, ' ');
+    for (auto &c : in) {
+      c = alphabet[rng() % alphabet.size()];
+    }
+    std::size_t from = in.empty() ? 0 : rng() % in.size();
+    auto expected = reference_find(patterns, in, from);
+    for (auto impl : supported_implementations()) {
+      PatternScanner scanner(patterns, impl);
+      auto m = scanner.find(in, from);
+      ASSERT_EQ(expected.position, m.position);
+      ASSERT_EQ(expected.pattern, m.pattern);
+    }
+  }
+}
+
+TEST(pattern_scanner, reports_which_patterns_occur) {
+  for (auto impl : supported_implementations()) {
+    PatternScanner scanner({"\r\n", "\n\n", "QUIT"}, impl);
+    std::string in(100, 'x');
+    ASSERT_EQ(0, scanner.occurring(in));
+    in += "QUIT\r\n";
+    ASSERT_EQ(0b101, scanner.occurring(in));
+  }
+}
+
+TEST(pattern_scanner, many_patterns_use_the_scalar_loop) {
+  std::vector<std::string> patterns;
+  for (char c = 'a'; c < 'a' + 12; c++) {
+    patterns.push_back(std::string(1, c) + "!");
+  }
+  PatternScanner scanner(patterns);
+  ASSERT_EQ(PatternScanner::Implementation::Scalar,
+            scanner.get_implementation());
+  auto m = scanner.find("zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzk!");
+  ASSERT_EQ(40, m.position);
+  ASSERT_EQ(10, m.pattern);
+}
+
+TEST(pattern_scanner, empty_list_finds_nothing) {
+  // sized exactly, so reading past the end is caught by the sanitizer.
+  std::vector<char> buffer(48, 'x');
+  std::string_view in(buffer.data(), buffer.size());
+  for (auto impl : supported_implementations()) {
+    PatternScanner scanner({}, impl);
+    ASSERT_EQ(PatternScanner::Implementation::Scalar,
+              scanner.get_implementation());
+    ASSERT_EQ(PatternScanner::npos, scanner.find(in).position);
+    ASSERT_EQ(PatternScanner::npos, scanner.find(in, 17).position);
+    ASSERT_EQ(0, scanner.occurring(in));
+  }
+}
+
+TEST(pattern_scanner, rejects_empty_patterns) {
+  ASSERT_THROW(PatternScanner({""}), std::invalid_argument);
+}
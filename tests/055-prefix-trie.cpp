@@ -0,0 +1,90 @@
+#include <networkprotocoldsl/support/prefixtrie.hpp>
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using networkprotocoldsl::support::PrefixTrie;
+
+static const std::vector<std::string> smtp_commands = {
+    "HELO ", "EHLO ", "MAIL FROM:", "RCPT TO:", "DATA\r\n",
+    "RSET\r\n", "NOOP\r\n", "QUIT\r\n", "VRFY "};
+
+TEST(prefix_trie, shares_prefixes) {
+  PrefixTrie trie({"RSET", "RCPT", "QUIT"});
+  // the root, "R", "RS", "RSE", "RSET", "RC", "RCP", "RCPT", and the
+  // four of "QUIT".
+  ASSERT_EQ(12, trie.states());
+  ASSERT_EQ(3, trie.reachable(PrefixTrie::root));
+  auto r = trie.step(PrefixTrie::root, 'R');
+  ASSERT_EQ(2, trie.reachable(r));
+  auto rc = trie.step(r, 'C');
+  ASSERT_EQ(1, trie.reachable(rc));
+  ASSERT_EQ(1, trie.only_reachable(rc));
+  ASSERT_EQ(PrefixTrie::npos, trie.only_reachable(r));
+}
+
+TEST(prefix_trie, stops_at_the_first_mismatch) {
+  PrefixTrie trie(smtp_commands);
+  std::size_t passed = PrefixTrie::npos;
+  auto state = trie.walk(PrefixTrie::root, "HELP me", passed);
+  ASSERT_EQ(PrefixTrie::dead, state);
+  ASSERT_EQ(0, trie.reachable(state));
+  ASSERT_EQ(PrefixTrie::npos, passed);
+  // bytes in none of the strings are all the same class.
+  ASSERT_EQ(PrefixTrie::dead, trie.step(PrefixTrie::root, '\xff'));
+}
+
+TEST(prefix_trie, reports_strings_the_input_went_past) {
+  PrefixTrie trie({"AB", "A", "ABC", "A"});
+  std::size_t passed = PrefixTrie::npos;
+  auto state = trie.walk(PrefixTrie::root, "A", passed);
+  // equal to "A" isn't past it yet.
+  ASSERT_EQ(PrefixTrie::npos, passed);
+  ASSERT_EQ(1, trie.ends_at(state));
+  state = trie.walk(state, "B", passed);
+  ASSERT_EQ(1, passed);
+  ASSERT_EQ(0, trie.ends_at(state));
+  // past "AB" too, which is listed before "A".
+  state = trie.walk(state, "CD", passed);
+  ASSERT_EQ(0, passed);
+  ASSERT_EQ(PrefixTrie::dead, state);
+}
+
+TEST(prefix_trie, agrees_with_comparing_every_string) {
+  PrefixTrie trie(smtp_commands);
+  std::mt19937 rng(7);
+  for (int round = 0; round < 500; round++) {
+    // mostly the start of one of the commands, and then anything.
+    std::string in = smtp_commands[rng() % smtp_commands.size()];
+    in.resize(rng() % (in.size() + 3), 'x');
+    if (!in.empty() && rng() % 4 == 0) {
+      in[rng() % in.size()] = "AEHLMR :\r"[rng() % 9];
+    }
+
+    // fed in pieces, as reads would.
+    auto state = PrefixTrie::root;
+    std::size_t passed = PrefixTrie::npos;
+    for (std::size_t pos = 0; pos < in.size();) {
+      std::size_t n = 1 + rng() % 3;
+      state = trie.walk(state, std::string_view(in).substr(pos, n), passed);
+      pos += n;
+    }
+
+    std::size_t expected_passed = PrefixTrie::npos;
+    std::size_t expected_reachable = 0;
+    for (std::size_t i = 0; i < smtp_commands.size(); i++) {
+      const auto &c = smtp_commands[i];
+      if (in.size() > c.size() && in.starts_with(c) &&
+          expected_passed == PrefixTrie::npos) {
+        expected_passed = i;
+      }
+      if (in.size() <= c.size() && c.starts_with(in)) {
+        expected_reachable++;
+      }
+    }
+    ASSERT_EQ(expected_passed, passed) << in;
+    ASSERT_EQ(expected_reachable, trie.reachable(state)) << in;
+  }
+}
@@ -0,0 +1,72 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/writeint32native.hpp>
+#include <networkprotocoldsl/operation/writeoctets.hpp>
+#include <networkprotocoldsl/operation/writestaticoctets.hpp>
+#include <networkprotocoldsl/operationconcepts.hpp>
+#include <networkprotocoldsl/optree.hpp>
+#include <networkprotocoldsl/value.hpp>
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <variant>
+
+using namespace networkprotocoldsl;
+
+// longer than fits in std::string itself, so it is reference counted.
+static const std::string long_text =
+    "250-smtp.example.com Hello client.example.org\r\n";
+
+TEST(write_octets_sharing, static_octets_are_not_copied) {
+  operation::WriteStaticOctets op(long_text);
+  InputOutputOperationContext ctx;
+  auto r = op(ctx, {});
+  ASSERT_EQ(ReasonForBlockedOperation::WaitingForWrite,
+            std::get<ReasonForBlockedOperation>(r));
+
+  auto octets = op.get_write_octets(ctx);
+  ASSERT_EQ(long_text, octets.data.view());
+  // the bytes of the operation itself.
+  ASSERT_EQ(op.get_contents().data(), octets.data.view().data());
+
+  // what is left after a partial write.
+  ASSERT_EQ(4, op.handle_write(ctx, 4));
+  ASSERT_EQ(long_text.substr(4), op.get_write_octets(ctx).data.view());
+  ASSERT_EQ(long_text.size() - 4, op.handle_write(ctx, 1000));
+  ASSERT_EQ(0, std::get<int32_t>(std::get<Value>(op(ctx, {}))));
+}
+
+TEST(write_octets_sharing, values_are_not_copied) {
+  operation::WriteOctets op;
+  auto shared = std::make_shared<const std::string>(long_text);
+  InputOutputOperationContext ctx;
+  auto r = op(ctx, {value::Octets(shared)});
+  ASSERT_EQ(ReasonForBlockedOperation::WaitingForWrite,
+            std::get<ReasonForBlockedOperation>(r));
+  ASSERT_EQ(shared->data(), op.get_write_octets(ctx).data.view().data());
+  ASSERT_EQ(shared->data(), op.get_write_buffer(ctx).data());
+}
+
+TEST(write_octets_sharing, interpreter_hands_over_the_octets) {
+  operation::WriteStaticOctets wso(long_text);
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree({wso, {}})));
+  Interpreter i = p.get_instance();
+  ASSERT_EQ(ContinuationState::Blocked, i.step());
+  auto octets = i.get_write_octets();
+  ASSERT_EQ(i.get_write_buffer().data(), octets.data.view().data());
+  i.handle_write(octets.data.view().size());
+  ASSERT_EQ(ContinuationState::Exited, i.step());
+}
+
+TEST(write_octets_sharing, other_writes_are_copied) {
+  operation::WriteInt32Native wi;
+  InterpretedProgram p(std::make_shared<OpTree>(
+      OpTree({wi, {{operation::Int32Literal{42}, {}}}})));
+  Interpreter i = p.get_instance();
+  while (i.step() != ContinuationState::Blocked) {
+  }
+  auto octets = i.get_write_octets();
+  ASSERT_EQ(4, octets.data.view().size());
+  ASSERT_EQ(i.get_write_buffer(), octets.data.view());
+}
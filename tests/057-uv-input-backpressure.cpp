@@ -0,0 +1,165 @@
+#include <networkprotocoldsl/interpretedprogram.hpp>
+#include <networkprotocoldsl/interpretercollectionmanager.hpp>
+#include <networkprotocoldsl/interpreterrunner.hpp>
+#include <networkprotocoldsl/operation/int32literal.hpp>
+#include <networkprotocoldsl/operation/opsequence.hpp>
+#include <networkprotocoldsl/operation/readoctetsuntilterminator.hpp>
+#include <networkprotocoldsl/operation/unarycallback.hpp>
+#include <networkprotocoldsl/operation/writestaticoctets.hpp>
+#include <networkprotocoldsl/optree.hpp>
+#include <networkprotocoldsl_uv/asyncworkqueue.hpp>
+#include <networkprotocoldsl_uv/libuvserverrunner.hpp>
+
+#include <uv.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+using namespace networkprotocoldsl;
+using namespace networkprotocoldsl_uv;
+
+static int connect_to(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) !=
+      0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Reads until the expected number of bytes arrived, or nothing did for
+// the given time.
+static std::string receive(int fd, std::size_t size,
+                           std::chrono::milliseconds timeout) {
+  std::string out;
+  char buf[64];
+  while (out.size() < size) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout.count()) <= 0) {
+      break;
+    }
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      break;
+    }
+    out.append(buf, n);
+  }
+  return out;
+}
+
+/**
+ * The first connection waits on a callback that doesn't finish while
+ * its peer keeps sending, which fills its input queue. The loop stops
+ * reading from it instead of waiting for room, so the second
+ * connection is still accepted and served, and once the callback
+ * finishes the first one gets everything that was sent.
+ */
+TEST(uv_input_backpressure, flooded_connection_does_not_stall_the_loop) {
+  operation::OpSequence ops;
+  operation::UnaryCallback callback("work");
+  operation::Int32Literal zero(0);
+  operation::ReadOctetsUntilTerminator line("\n");
+  operation::WriteStaticOctets done("done\n");
+  // reads once more so the connection stays open until the peer
+  // closes it.
+  InterpretedProgram p(std::make_shared<OpTree>(OpTree(
+      {ops, {{callback, {{zero, {}}}}, {line, {}}, {done, {}}, {line, {}}}})));
+
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+  AsyncWorkQueue async_queue(&loop);
+  std::thread io_thread([&loop]() { uv_run(&loop, UV_RUN_DEFAULT); });
+
+  std::mutex mtx;
+  std::optional<CallbackCompletion> held;
+  std::promise<void> first_started;
+  InterpreterCollectionManager mgr;
+  InterpreterRunner runner;
+  runner.async_callbacks.emplace(
+      "work", [&](const std::vector<Value> &args, CallbackCompletion c) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!held.has_value()) {
+          held.emplace(std::move(c));
+          first_started.set_value();
+        } else {
+          c(0);
+        }
+      });
+  LibuvServerRunner server(mgr, &loop, "127.0.0.1", 0, p, async_queue);
+  std::thread worker([&runner, &mgr] { runner.interpreter_loop(mgr); });
+  std::thread callbacks([&runner, &mgr] { runner.callback_loop(mgr); });
+  auto bind_result = server.bind_result.get_future().get();
+  ASSERT_TRUE(std::holds_alternative<BindInfo>(bind_result));
+  int port = std::get<BindInfo>(bind_result).port;
+
+  int flooded = connect_to(port);
+  ASSERT_NE(-1, flooded);
+  ASSERT_EQ(std::future_status::ready,
+            first_started.get_future().wait_for(std::chrono::seconds(5)));
+
+  // far more than the input queue and the socket buffers can take.
+  constexpr std::size_t total = 64 * 1024 * 1024;
+  std::atomic<std::size_t> sent = 0;
+  std::thread sender([flooded, &sent] {
+    std::string block(64 * 1024, 'x');
+    while (sent.load() < total) {
+      ssize_t n = send(flooded, block.data(), block.size(), MSG_NOSIGNAL);
+      if (n <= 0) {
+        return;
+      }
+      sent += n;
+    }
+    send(flooded, "\n", 1, MSG_NOSIGNAL);
+  });
+  // the server stopped reading once the sender can't make progress.
+  std::size_t last = 0;
+  do {
+    last = sent.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  } while (sent.load() != last);
+  ASSERT_LT(last, total);
+
+  int other = connect_to(port);
+  ASSERT_NE(-1, other);
+  ASSERT_EQ(1, send(other, "\n", 1, MSG_NOSIGNAL));
+  ASSERT_EQ("done\n", receive(other, 5, std::chrono::seconds(5)));
+
+  {
+    std::lock_guard<std::mutex> lk(mtx);
+    (*held)(0);
+    held.reset();
+  }
+  sender.join();
+  ASSERT_EQ(total, sent.load());
+  ASSERT_EQ("done\n", receive(flooded, 5, std::chrono::seconds(10)));
+
+  close(flooded);
+  close(other);
+  server.stop_accepting();
+  runner.exit_when_done.store(true);
+  mgr.get_collection()->signals->wake_up_interpreter.notify();
+  mgr.get_collection()->signals->wake_up_for_callback.notify();
+  worker.join();
+  callbacks.join();
+  server.server_stopped.wait();
+  async_queue.shutdown().wait();
+  io_thread.join();
+  uv_loop_close(&loop);
+}